@@ -0,0 +1,556 @@
+/** @file BPlusTree.cpp */
+
+#include "BPlusTree.hpp"
+#include <algorithm>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
+template <class T, class KeyPolicy>
+BPlusTree<T, KeyPolicy>::Node::Node(bool is_leaf) : leaf(is_leaf), count(0)
+{
+  std::fill(packed, packed + kOrder, ~std::uint64_t(0));
+} // end constructor
+
+template <class T, class KeyPolicy>
+BPlusTree<T, KeyPolicy>::Leaf::Leaf() : Node(true), next(nullptr)
+{
+} // end constructor
+
+template <class T, class KeyPolicy>
+BPlusTree<T, KeyPolicy>::Inner::Inner() : Node(false)
+{
+} // end constructor
+
+template <class T, class KeyPolicy>
+BPlusTree<T, KeyPolicy>::BPlusTree() : root_ptr_(nullptr), size_(0)
+{
+} // end default constructor
+
+template <class T, class KeyPolicy>
+BPlusTree<T, KeyPolicy>::BPlusTree(const BPlusTree &another_tree) : root_ptr_(nullptr), size_(another_tree.size_)
+{
+  Leaf *last_leaf = nullptr;
+  if (another_tree.root_ptr_ != nullptr)
+    root_ptr_ = copyHelper(another_tree.root_ptr_.get(), last_leaf);
+} // end copy constructor
+
+template <class T, class KeyPolicy>
+BPlusTree<T, KeyPolicy> &BPlusTree<T, KeyPolicy>::operator=(const BPlusTree &another_tree)
+{
+  if (this != &another_tree)
+  {
+    Leaf *last_leaf = nullptr;
+    root_ptr_ = another_tree.root_ptr_ == nullptr ? nullptr : copyHelper(another_tree.root_ptr_.get(), last_leaf);
+    size_ = another_tree.size_;
+  }
+  return *this;
+} // end operator=
+
+template <class T, class KeyPolicy>
+BPlusTree<T, KeyPolicy>::BPlusTree(BPlusTree &&another_tree)
+    : root_ptr_(std::move(another_tree.root_ptr_)), size_(another_tree.size_)
+{
+  another_tree.size_ = 0;
+} // end move constructor
+
+template <class T, class KeyPolicy>
+BPlusTree<T, KeyPolicy> &BPlusTree<T, KeyPolicy>::operator=(BPlusTree &&another_tree)
+{
+  if (this != &another_tree)
+  {
+    root_ptr_ = std::move(another_tree.root_ptr_);
+    size_ = another_tree.size_;
+    another_tree.size_ = 0;
+  }
+  return *this;
+} // end move assignment
+
+template <class T, class KeyPolicy>
+bool BPlusTree<T, KeyPolicy>::isEmpty() const
+{
+  return size_ == 0;
+} // end isEmpty
+
+template <class T, class KeyPolicy>
+std::size_t BPlusTree<T, KeyPolicy>::size() const
+{
+  return size_;
+} // end size
+
+template <class T, class KeyPolicy>
+int BPlusTree<T, KeyPolicy>::getHeight() const
+{
+  int height = 0;
+  for (const Node *node = root_ptr_.get(); node != nullptr;
+       node = node->leaf ? nullptr : static_cast<const Inner *>(node)->children[0].get())
+    height++;
+  return height;
+} // end getHeight
+
+template <class T, class KeyPolicy>
+bool BPlusTree<T, KeyPolicy>::add(const T &new_entry)
+{
+  return addEntry(new_entry);
+} // end add
+
+template <class T, class KeyPolicy>
+bool BPlusTree<T, KeyPolicy>::add(T &&new_entry)
+{
+  return addEntry(std::move(new_entry));
+} // end add
+
+template <class T, class KeyPolicy>
+bool BPlusTree<T, KeyPolicy>::remove(const T &entry)
+{
+  return erase(KeyPolicy::key(entry));
+} // end remove
+
+template <class T, class KeyPolicy>
+template <class K>
+bool BPlusTree<T, KeyPolicy>::erase(const K &key)
+{
+  if (root_ptr_ == nullptr || !eraseHelper(root_ptr_.get(), std::string_view(key)))
+    return false;
+  size_--;
+  // Drop a root that is left empty or with a single child
+  if (root_ptr_->count == 0)
+  {
+    if (root_ptr_->leaf)
+      root_ptr_.reset();
+    else
+      root_ptr_ = std::move(static_cast<Inner *>(root_ptr_.get())->children[0]);
+  }
+  return true;
+} // end erase
+
+template <class T, class KeyPolicy>
+bool BPlusTree<T, KeyPolicy>::contains(const T &entry) const
+{
+  return find(KeyPolicy::key(entry)) != nullptr;
+} // end contains
+
+template <class T, class KeyPolicy>
+template <class K>
+bool BPlusTree<T, KeyPolicy>::contains(const K &key) const
+{
+  return find(key) != nullptr;
+} // end contains
+
+template <class T, class KeyPolicy>
+template <class K>
+const T *BPlusTree<T, KeyPolicy>::find(const K &key) const
+{
+  std::string_view target(key);
+  const Node *node = root_ptr_.get();
+  if (node == nullptr)
+    return nullptr;
+  while (!node->leaf)
+    node = static_cast<const Inner *>(node)->children[rank(node, target, true)].get();
+  int i = rank(node, target, false);
+  if (i < node->count && keyAt(node, i) == target)
+    return &static_cast<const Leaf *>(node)->items[i];
+  return nullptr;
+} // end find
+
+template <class T, class KeyPolicy>
+template <class Visit>
+void BPlusTree<T, KeyPolicy>::forEach(Visit visit) const
+{
+  const Node *node = root_ptr_.get();
+  if (node == nullptr)
+    return;
+  while (!node->leaf)
+    node = static_cast<const Inner *>(node)->children[0].get();
+  for (const Leaf *leaf = static_cast<const Leaf *>(node); leaf != nullptr; leaf = leaf->next)
+    for (int i = 0; i < leaf->count; i++)
+      visit(leaf->items[i]);
+} // end forEach
+
+template <class T, class KeyPolicy>
+void BPlusTree<T, KeyPolicy>::clear()
+{
+  root_ptr_.reset();
+  size_ = 0;
+} // end clear
+
+
+
+/*PRIVATE METHODS*/
+
+
+template <class T, class KeyPolicy>
+std::string_view BPlusTree<T, KeyPolicy>::keyAt(const Node *node, int i)
+{
+  if (node->leaf)
+    return std::string_view(KeyPolicy::key(static_cast<const Leaf *>(node)->items[i]));
+  return static_cast<const Inner *>(node)->keys[i];
+} // end keyAt
+
+template <class T, class KeyPolicy>
+int BPlusTree<T, KeyPolicy>::countLess(const std::uint64_t *packed, std::uint64_t target)
+{
+#if defined(__AVX2__)
+  // The compares are signed, so flip the top bit of both sides first
+  const __m256i bias = _mm256_set1_epi64x(static_cast<long long>(std::uint64_t(1) << 63));
+  const __m256i target_vec = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(target)), bias);
+  int count = 0;
+  for (int i = 0; i < kOrder; i += 4)
+  {
+    __m256i slots = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(packed + i)), bias);
+    count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(target_vec, slots))));
+  }
+  return count;
+#elif defined(__SSE4_2__)
+  const __m128i bias = _mm_set1_epi64x(static_cast<long long>(std::uint64_t(1) << 63));
+  const __m128i target_vec = _mm_xor_si128(_mm_set1_epi64x(static_cast<long long>(target)), bias);
+  int count = 0;
+  for (int i = 0; i < kOrder; i += 2)
+  {
+    __m128i slots = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(packed + i)), bias);
+    count += __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(target_vec, slots))));
+  }
+  return count;
+#else
+  int count = 0;
+  for (int i = 0; i < kOrder; i++)
+    count += packed[i] < target;
+  return count;
+#endif
+} // end countLess
+
+template <class T, class KeyPolicy>
+int BPlusTree<T, KeyPolicy>::countGreater(const std::uint64_t *packed, std::uint64_t target)
+{
+#if defined(__AVX2__)
+  const __m256i bias = _mm256_set1_epi64x(static_cast<long long>(std::uint64_t(1) << 63));
+  const __m256i target_vec = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(target)), bias);
+  int count = 0;
+  for (int i = 0; i < kOrder; i += 4)
+  {
+    __m256i slots = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(packed + i)), bias);
+    count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(slots, target_vec))));
+  }
+  return count;
+#elif defined(__SSE4_2__)
+  const __m128i bias = _mm_set1_epi64x(static_cast<long long>(std::uint64_t(1) << 63));
+  const __m128i target_vec = _mm_xor_si128(_mm_set1_epi64x(static_cast<long long>(target)), bias);
+  int count = 0;
+  for (int i = 0; i < kOrder; i += 2)
+  {
+    __m128i slots = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(packed + i)), bias);
+    count += __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(slots, target_vec))));
+  }
+  return count;
+#else
+  int count = 0;
+  for (int i = 0; i < kOrder; i++)
+    count += packed[i] > target;
+  return count;
+#endif
+} // end countGreater
+
+template <class T, class KeyPolicy>
+std::uint64_t BPlusTree<T, KeyPolicy>::pack(std::string_view key, std::size_t offset)
+{
+  std::uint64_t packed = 0;
+  for (std::size_t i = offset; i < offset + 8; i++)
+    packed = (packed << 8) | (i < key.size() ? static_cast<unsigned char>(key[i]) : 0);
+  return packed;
+} // end pack
+
+template <class T, class KeyPolicy>
+void BPlusTree<T, KeyPolicy>::refresh(Node *node)
+{
+  // Keys are sorted, so the prefix of the first and last is shared by all
+  std::size_t length = 0;
+  if (node->count > 0)
+  {
+    std::string_view first = keyAt(node, 0);
+    std::string_view last = keyAt(node, node->count - 1);
+    while (length < first.size() && length < last.size() && first[length] == last[length])
+      length++;
+    node->shared.assign(first.data(), length);
+  }
+  else
+    node->shared.clear();
+  for (int i = 0; i < kOrder; i++)
+    node->packed[i] = i < node->count ? pack(keyAt(node, i), length) : ~std::uint64_t(0);
+} // end refresh
+
+template <class T, class KeyPolicy>
+int BPlusTree<T, KeyPolicy>::rank(const Node *node, std::string_view key, bool inclusive)
+{
+  // A key outside the shared prefix is before or after every key of the node
+  int order = key.substr(0, node->shared.size()).compare(node->shared);
+  if (order < 0)
+    return 0;
+  if (order > 0)
+    return node->count;
+  std::uint64_t target = pack(key, node->shared.size());
+  int low = countLess(node->packed, target);
+  int high = std::min(node->count, kOrder - countGreater(node->packed, target));
+  // The keys in [low, high) tie with key on their packed bytes
+  while (low < high && (inclusive ? keyAt(node, low) <= key : keyAt(node, low) < key))
+    low++;
+  return low;
+} // end rank
+
+template <class T, class KeyPolicy>
+template <class U>
+bool BPlusTree<T, KeyPolicy>::addEntry(U &&entry)
+{
+  if (root_ptr_ == nullptr)
+  {
+    std::unique_ptr<Leaf> leaf(new Leaf());
+    leaf->items[0] = std::forward<U>(entry);
+    leaf->count = 1;
+    refresh(leaf.get());
+    root_ptr_ = std::move(leaf);
+    size_ = 1;
+    return true;
+  }
+  std::unique_ptr<Node> split_right;
+  std::string separator;
+  if (!insertHelper(root_ptr_.get(), std::string_view(KeyPolicy::key(entry)), entry, split_right, separator))
+    return false;
+  if (split_right != nullptr)
+  {
+    // The root split: grow a level
+    std::unique_ptr<Inner> new_root(new Inner());
+    new_root->keys[0] = std::move(separator);
+    new_root->children[0] = std::move(root_ptr_);
+    new_root->children[1] = std::move(split_right);
+    new_root->count = 1;
+    refresh(new_root.get());
+    root_ptr_ = std::move(new_root);
+  }
+  size_++;
+  return true;
+} // end addEntry
+
+template <class T, class KeyPolicy>
+template <class U>
+bool BPlusTree<T, KeyPolicy>::insertHelper(Node *node, std::string_view key, U &entry, std::unique_ptr<Node> &split_right,
+                                           std::string &separator)
+{
+  const int half = kOrder / 2;
+  if (node->leaf)
+  {
+    Leaf *leaf = static_cast<Leaf *>(node);
+    int i = rank(leaf, key, false);
+    if (i < leaf->count && keyAt(leaf, i) == key)
+      return false; // already there
+    Leaf *target = leaf;
+    if (leaf->count == kOrder)
+    {
+      // Move the upper half to a new right sibling, then insert into the half i falls in
+      std::unique_ptr<Leaf> right(new Leaf());
+      std::move(leaf->items + half, leaf->items + kOrder, right->items);
+      right->count = kOrder - half;
+      leaf->count = half;
+      right->next = leaf->next;
+      leaf->next = right.get();
+      if (i > half)
+      {
+        target = right.get();
+        i -= half;
+      }
+      split_right = std::move(right);
+    }
+    std::move_backward(target->items + i, target->items + target->count, target->items + target->count + 1);
+    target->items[i] = std::forward<U>(entry);
+    target->count++;
+    refresh(leaf);
+    if (split_right != nullptr)
+    {
+      refresh(split_right.get());
+      separator = std::string(keyAt(split_right.get(), 0));
+    }
+    return true;
+  }
+
+  Inner *inner = static_cast<Inner *>(node);
+  int i = rank(inner, key, true);
+  std::unique_ptr<Node> child_right;
+  std::string child_separator;
+  if (!insertHelper(inner->children[i].get(), key, entry, child_right, child_separator))
+    return false;
+  if (child_right == nullptr)
+    return true;
+  Inner *target = inner;
+  if (inner->count == kOrder)
+  {
+    // The middle key moves up; the keys after it and their children move right
+    std::unique_ptr<Inner> right(new Inner());
+    std::move(inner->keys + half + 1, inner->keys + kOrder, right->keys);
+    std::move(inner->children + half + 1, inner->children + kOrder + 1, right->children);
+    right->count = kOrder - half - 1;
+    separator = std::move(inner->keys[half]);
+    inner->count = half;
+    if (i > half)
+    {
+      target = right.get();
+      i -= half + 1;
+    }
+    split_right = std::move(right);
+  }
+  std::move_backward(target->keys + i, target->keys + target->count, target->keys + target->count + 1);
+  std::move_backward(target->children + i + 1, target->children + target->count + 1, target->children + target->count + 2);
+  target->keys[i] = std::move(child_separator);
+  target->children[i + 1] = std::move(child_right);
+  target->count++;
+  refresh(inner);
+  if (split_right != nullptr)
+    refresh(split_right.get());
+  return true;
+} // end insertHelper
+
+template <class T, class KeyPolicy>
+bool BPlusTree<T, KeyPolicy>::eraseHelper(Node *node, std::string_view key)
+{
+  if (node->leaf)
+  {
+    Leaf *leaf = static_cast<Leaf *>(node);
+    int i = rank(leaf, key, false);
+    if (i == leaf->count || keyAt(leaf, i) != key)
+      return false;
+    std::move(leaf->items + i + 1, leaf->items + leaf->count, leaf->items + i);
+    leaf->count--;
+    leaf->items[leaf->count] = T(); // release what the vacated slot holds
+    refresh(leaf);
+    return true;
+  }
+  Inner *inner = static_cast<Inner *>(node);
+  int i = rank(inner, key, true);
+  if (!eraseHelper(inner->children[i].get(), key))
+    return false;
+  if (inner->children[i]->count < kMinCount)
+    fixUnderflow(inner, i);
+  return true;
+} // end eraseHelper
+
+template <class T, class KeyPolicy>
+void BPlusTree<T, KeyPolicy>::fixUnderflow(Inner *parent, int i)
+{
+  Node *child = parent->children[i].get();
+  Node *left = i > 0 ? parent->children[i - 1].get() : nullptr;
+  Node *right = i < parent->count ? parent->children[i + 1].get() : nullptr;
+
+  if (left != nullptr && left->count > kMinCount)
+  {
+    // Borrow the last key of the left sibling
+    if (child->leaf)
+    {
+      Leaf *to = static_cast<Leaf *>(child);
+      Leaf *from = static_cast<Leaf *>(left);
+      std::move_backward(to->items, to->items + to->count, to->items + to->count + 1);
+      to->items[0] = std::move(from->items[from->count - 1]);
+      from->items[from->count - 1] = T();
+      from->count--;
+      to->count++;
+      parent->keys[i - 1] = std::string(keyAt(to, 0));
+    }
+    else
+    {
+      Inner *to = static_cast<Inner *>(child);
+      Inner *from = static_cast<Inner *>(left);
+      std::move_backward(to->keys, to->keys + to->count, to->keys + to->count + 1);
+      std::move_backward(to->children, to->children + to->count + 1, to->children + to->count + 2);
+      to->keys[0] = std::move(parent->keys[i - 1]);
+      to->children[0] = std::move(from->children[from->count]);
+      parent->keys[i - 1] = std::move(from->keys[from->count - 1]);
+      from->count--;
+      to->count++;
+    }
+    refresh(left);
+  }
+  else if (right != nullptr && right->count > kMinCount)
+  {
+    // Borrow the first key of the right sibling
+    if (child->leaf)
+    {
+      Leaf *to = static_cast<Leaf *>(child);
+      Leaf *from = static_cast<Leaf *>(right);
+      to->items[to->count] = std::move(from->items[0]);
+      std::move(from->items + 1, from->items + from->count, from->items);
+      from->items[from->count - 1] = T();
+      from->count--;
+      to->count++;
+      parent->keys[i] = std::string(keyAt(from, 0));
+    }
+    else
+    {
+      Inner *to = static_cast<Inner *>(child);
+      Inner *from = static_cast<Inner *>(right);
+      to->keys[to->count] = std::move(parent->keys[i]);
+      to->children[to->count + 1] = std::move(from->children[0]);
+      parent->keys[i] = std::move(from->keys[0]);
+      std::move(from->keys + 1, from->keys + from->count, from->keys);
+      std::move(from->children + 1, from->children + from->count + 1, from->children);
+      from->count--;
+      to->count++;
+    }
+    refresh(right);
+  }
+  else
+  {
+    // Merge with a sibling; both are at the minimum, so the result fits
+    int left_index = left != nullptr ? i - 1 : i;
+    Node *into = parent->children[left_index].get();
+    Node *from = parent->children[left_index + 1].get();
+    if (into->leaf)
+    {
+      Leaf *to = static_cast<Leaf *>(into);
+      Leaf *source = static_cast<Leaf *>(from);
+      std::move(source->items, source->items + source->count, to->items + to->count);
+      to->count += source->count;
+      to->next = source->next;
+    }
+    else
+    {
+      Inner *to = static_cast<Inner *>(into);
+      Inner *source = static_cast<Inner *>(from);
+      to->keys[to->count] = std::move(parent->keys[left_index]);
+      std::move(source->keys, source->keys + source->count, to->keys + to->count + 1);
+      std::move(source->children, source->children + source->count + 1, to->children + to->count + 1);
+      to->count += source->count + 1;
+    }
+    std::move(parent->keys + left_index + 1, parent->keys + parent->count, parent->keys + left_index);
+    std::move(parent->children + left_index + 2, parent->children + parent->count + 1, parent->children + left_index + 1);
+    parent->children[parent->count].reset();
+    parent->count--;
+    child = into;
+  }
+  refresh(child);
+  refresh(parent);
+} // end fixUnderflow
+
+template <class T, class KeyPolicy>
+std::unique_ptr<typename BPlusTree<T, KeyPolicy>::Node> BPlusTree<T, KeyPolicy>::copyHelper(const Node *node, Leaf *&last_leaf)
+{
+  if (node->leaf)
+  {
+    const Leaf *leaf = static_cast<const Leaf *>(node);
+    std::unique_ptr<Leaf> copy(new Leaf());
+    std::copy(leaf->items, leaf->items + leaf->count, copy->items);
+    copy->count = leaf->count;
+    copy->shared = leaf->shared;
+    std::copy(leaf->packed, leaf->packed + kOrder, copy->packed);
+    if (last_leaf != nullptr)
+      last_leaf->next = copy.get();
+    last_leaf = copy.get();
+    return copy;
+  }
+  const Inner *inner = static_cast<const Inner *>(node);
+  std::unique_ptr<Inner> copy(new Inner());
+  std::copy(inner->keys, inner->keys + inner->count, copy->keys);
+  for (int i = 0; i <= inner->count; i++)
+    copy->children[i] = copyHelper(inner->children[i].get(), last_leaf);
+  copy->count = inner->count;
+  copy->shared = inner->shared;
+  std::copy(inner->packed, inner->packed + kOrder, copy->packed);
+  return copy;
+} // end copyHelper
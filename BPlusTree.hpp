@@ -0,0 +1,159 @@
+/** A B+ tree for items ordered by a string key, laid out for fast lookups.
+ Every node holds up to kOrder keys. Next to its keys, each node keeps the
+ prefix all of them share, and for every key the 8 bytes that follow that
+ prefix packed into a big-endian integer, so integer order agrees with key
+ order. A node is searched by comparing the packed target against all
+ kOrder integers at once with SIMD compares (AVX2 or SSE4.2 when the
+ compiler targets them, a plain loop otherwise); full keys are compared
+ only for the keys whose 8 bytes tie with the target. Items live in the
+ leaves, which are chained in key order.
+ Keys are unique: add does nothing when an item with the same key exists.
+ @tparam KeyPolicy extracts the key items are ordered by (see KeyPolicy.hpp);
+ KeyPolicy::key(item) must convert to std::string_view.
+ @file BPlusTree.hpp */
+
+#ifndef B_PLUS_TREE_
+#define B_PLUS_TREE_
+
+#include "KeyPolicy.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+template <class T, class KeyPolicy = IdentityKey>
+class BPlusTree
+{
+public:
+  static constexpr int kOrder = 16; // keys per node; a node's packed keys fill two cache lines
+
+  BPlusTree();
+  BPlusTree(const BPlusTree &another_tree);
+  BPlusTree &operator=(const BPlusTree &another_tree);
+  BPlusTree(BPlusTree &&another_tree);
+  BPlusTree &operator=(BPlusTree &&another_tree);
+
+  /** @return true if the tree is empty **/
+  bool isEmpty() const;
+
+  /** @return the number of items **/
+  std::size_t size() const;
+
+  /** @return the number of levels, 0 if empty **/
+  int getHeight() const;
+
+  /** @param new_entry an entry to be added if no entry with the same key exists
+      @return true if new_entry was added **/
+  bool add(const T &new_entry);
+
+  /** @param new_entry an entry to be moved in if no entry with the same key exists
+      @return true if new_entry was added; it is only moved from if so **/
+  bool add(T &&new_entry);
+
+  /** @param entry the entry to be removed
+      @return true if the entry with entry's key was removed **/
+  bool remove(const T &entry);
+
+  /** @param key a key of any type that converts to std::string_view
+      @return true if the entry with that key was removed **/
+  template <class K>
+  bool erase(const K &key);
+
+  /** @param entry to be found
+      @return true if an entry with entry's key is in the tree **/
+  bool contains(const T &entry) const;
+
+  /** @param key a key of any type that converts to std::string_view
+      @return true if an entry with that key is in the tree **/
+  template <class K>
+  bool contains(const K &key) const;
+
+  /** @param key a key of any type that converts to std::string_view
+      @return the entry with that key, nullptr if not found **/
+  template <class K>
+  const T *find(const K &key) const;
+
+  /** @param visit called with every entry, in key order, along the leaf chain **/
+  template <class Visit>
+  void forEach(Visit visit) const;
+
+  /** @post the tree is empty **/
+  void clear();
+
+private:
+  static constexpr int kMinCount = kOrder / 2 - 1; // keys a non-root node keeps
+
+  struct Node
+  {
+    bool leaf;
+    int count;
+    std::string shared;                 // a prefix every key in the node starts with
+    std::uint64_t packed[kOrder];       // 8 key bytes after shared; unused slots are all ones
+    explicit Node(bool is_leaf);
+    virtual ~Node() = default;
+  };
+
+  struct Leaf : Node
+  {
+    T items[kOrder];
+    Leaf *next; // the leaf holding the next keys
+    Leaf();
+  };
+
+  struct Inner : Node
+  {
+    std::string keys[kOrder];                    // keys[i] separates children i and i + 1
+    std::unique_ptr<Node> children[kOrder + 1];
+    Inner();
+  };
+
+  std::unique_ptr<Node> root_ptr_;
+  std::size_t size_;
+
+  /** @return the key of slot i of node **/
+  static std::string_view keyAt(const Node *node, int i);
+
+  /** @return the kOrder slots of packed compared to target: how many are less,
+              and how many are greater **/
+  static int countLess(const std::uint64_t *packed, std::uint64_t target);
+  static int countGreater(const std::uint64_t *packed, std::uint64_t target);
+
+  /** @return the 8 bytes of key from offset on as a big-endian integer, zero padded **/
+  static std::uint64_t pack(std::string_view key, std::size_t offset);
+
+  /** @post shared and packed of node match its keys **/
+  static void refresh(Node *node);
+
+  /** @param inclusive whether keys equal to key are counted
+      @return the number of keys in node less than key, or not greater if inclusive **/
+  static int rank(const Node *node, std::string_view key, bool inclusive);
+
+  /** called by add
+      @param key the key of entry, which must stay valid until entry is moved
+      @param split_right set to the new right sibling if node was split
+      @param separator set to the first key of split_right if node was split
+      @return true if entry was added **/
+  template <class U>
+  bool insertHelper(Node *node, std::string_view key, U &entry, std::unique_ptr<Node> &split_right, std::string &separator);
+
+  /** called by add(const T&) and add(T&&) **/
+  template <class U>
+  bool addEntry(U &&entry);
+
+  /** called by erase and remove
+      @return true if the entry with key was removed from the subtree at node **/
+  bool eraseHelper(Node *node, std::string_view key);
+
+  /** called by eraseHelper
+      @post child i of parent has at least kMinCount keys again, borrowed from
+            or merged with a sibling **/
+  static void fixUnderflow(Inner *parent, int i);
+
+  /** called by the copy constructor and assignment
+      @param last_leaf the last leaf copied so far, linked to the next one **/
+  static std::unique_ptr<Node> copyHelper(const Node *node, Leaf *&last_leaf);
+};
+
+#include "BPlusTree.cpp"
+#endif
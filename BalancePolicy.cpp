@@ -0,0 +1,104 @@
+/** @file BalancePolicy.cpp */
+
+#include "BalancePolicy.hpp"
+#include <algorithm>
+
+template <class T>
+std::shared_ptr<BinaryNode<T>> NoBalancePolicy::rebalance(std::shared_ptr<BinaryNode<T>> subtree_ptr)
+{
+  return subtree_ptr;
+} // end rebalance
+
+template <class T, class Unshare>
+std::shared_ptr<BinaryNode<T>> NoBalancePolicy::rebalance(std::shared_ptr<BinaryNode<T>> subtree_ptr, const Unshare &)
+{
+  return subtree_ptr;
+} // end rebalance
+
+
+template <class T>
+int AvlPolicy::heightOf(const std::shared_ptr<BinaryNode<T>> &subtree_ptr)
+{
+  return subtree_ptr == nullptr ? 0 : subtree_ptr->getHeight();
+} // end heightOf
+
+
+template <class T>
+void AvlPolicy::updateHeight(const std::shared_ptr<BinaryNode<T>> &node_ptr)
+{
+  node_ptr->updateCounts();
+} // end updateHeight
+
+
+template <class T>
+std::shared_ptr<BinaryNode<T>> AvlPolicy::rotateLeft(std::shared_ptr<BinaryNode<T>> node_ptr)
+{
+  return rotateLeft(std::move(node_ptr), KeepNode());
+} // end rotateLeft
+
+
+template <class T, class Unshare>
+std::shared_ptr<BinaryNode<T>> AvlPolicy::rotateLeft(std::shared_ptr<BinaryNode<T>> node_ptr, const Unshare &unshare)
+{
+  std::shared_ptr<BinaryNode<T>> new_root = unshare(node_ptr->getRightChildPtr());
+  node_ptr->setRightChildPtr(new_root->getLeftChildPtr());
+  new_root->setLeftChildPtr(node_ptr);
+  updateHeight(node_ptr);
+  updateHeight(new_root);
+  return new_root;
+} // end rotateLeft
+
+
+template <class T>
+std::shared_ptr<BinaryNode<T>> AvlPolicy::rotateRight(std::shared_ptr<BinaryNode<T>> node_ptr)
+{
+  return rotateRight(std::move(node_ptr), KeepNode());
+} // end rotateRight
+
+
+template <class T, class Unshare>
+std::shared_ptr<BinaryNode<T>> AvlPolicy::rotateRight(std::shared_ptr<BinaryNode<T>> node_ptr, const Unshare &unshare)
+{
+  std::shared_ptr<BinaryNode<T>> new_root = unshare(node_ptr->getLeftChildPtr());
+  node_ptr->setLeftChildPtr(new_root->getRightChildPtr());
+  new_root->setRightChildPtr(node_ptr);
+  updateHeight(node_ptr);
+  updateHeight(new_root);
+  return new_root;
+} // end rotateRight
+
+
+template <class T>
+std::shared_ptr<BinaryNode<T>> AvlPolicy::rebalance(std::shared_ptr<BinaryNode<T>> subtree_ptr)
+{
+  return rebalance(std::move(subtree_ptr), KeepNode());
+} // end rebalance
+
+
+template <class T, class Unshare>
+std::shared_ptr<BinaryNode<T>> AvlPolicy::rebalance(std::shared_ptr<BinaryNode<T>> subtree_ptr, const Unshare &unshare)
+{
+  if (subtree_ptr == nullptr)
+    return subtree_ptr;
+
+  updateHeight(subtree_ptr);
+  int balance = heightOf(subtree_ptr->getLeftChildPtr()) - heightOf(subtree_ptr->getRightChildPtr());
+
+  if (balance > 1)
+  {
+    // Left heavy; a left-right case needs the left child turned first
+    std::shared_ptr<BinaryNode<T>> left = subtree_ptr->getLeftChildPtr();
+    if (heightOf(left->getLeftChildPtr()) < heightOf(left->getRightChildPtr()))
+      subtree_ptr->setLeftChildPtr(rotateLeft(unshare(left), unshare));
+    return rotateRight(subtree_ptr, unshare);
+  }
+  else if (balance < -1)
+  {
+    // Right heavy; a right-left case needs the right child turned first
+    std::shared_ptr<BinaryNode<T>> right = subtree_ptr->getRightChildPtr();
+    if (heightOf(right->getRightChildPtr()) < heightOf(right->getLeftChildPtr()))
+      subtree_ptr->setRightChildPtr(rotateRight(unshare(right), unshare));
+    return rotateLeft(subtree_ptr, unshare);
+  }
+  return subtree_ptr;
+} // end rebalance
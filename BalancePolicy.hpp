@@ -0,0 +1,92 @@
+/** Balancing policies for BinarySearchTree.
+ A policy is handed the root of a subtree after one of its children
+ changed (on the way back up from an add or a remove) and returns the
+ root that should take its place. The root's stored height and size are
+ already up to date, and a policy that moves nodes keeps them up to date
+ in every node it moves.
+ Trees that share nodes with snapshots also pass unshare: before a policy
+ changes any node other than the subtree root, it calls
+ unshare(node_ptr), which returns a node it may change in place (node_ptr
+ itself, or a copy that takes its place).
+ @file BalancePolicy.hpp */
+
+#ifndef BALANCE_POLICY_
+#define BALANCE_POLICY_
+
+#include "BinaryNode.hpp"
+#include <memory>
+
+/** Plain BST behaviour: nodes are never moved, so the shape of the tree
+    depends on the order of insertion. **/
+struct NoBalancePolicy
+{
+  /** @param subtree_ptr the root of a subtree whose children changed
+      @return subtree_ptr unchanged **/
+  template <class T>
+  static std::shared_ptr<BinaryNode<T>> rebalance(std::shared_ptr<BinaryNode<T>> subtree_ptr);
+
+  /** @return subtree_ptr unchanged; nothing is unshared **/
+  template <class T, class Unshare>
+  static std::shared_ptr<BinaryNode<T>> rebalance(std::shared_ptr<BinaryNode<T>> subtree_ptr, const Unshare &unshare);
+};
+
+/** AVL balancing: every node keeps the height of its subtree and a
+    single or double rotation is done whenever the heights of the two
+    children differ by more than 1, which bounds the height of the tree
+    by about 1.44 log2(n) after every add and remove. **/
+struct AvlPolicy
+{
+  /** @param subtree_ptr the root of a subtree whose children changed
+      @post the height and size stored in every touched node are up to date
+      @return the root of the subtree after the rotations, if any **/
+  template <class T>
+  static std::shared_ptr<BinaryNode<T>> rebalance(std::shared_ptr<BinaryNode<T>> subtree_ptr);
+
+  /** @param unshare called on every other node before it is rotated
+      @post same as rebalance(subtree_ptr) **/
+  template <class T, class Unshare>
+  static std::shared_ptr<BinaryNode<T>> rebalance(std::shared_ptr<BinaryNode<T>> subtree_ptr, const Unshare &unshare);
+
+  /** @return the stored height of the subtree, 0 for nullptr **/
+  template <class T>
+  static int heightOf(const std::shared_ptr<BinaryNode<T>> &subtree_ptr);
+
+  /** @post the stored height of node_ptr is 1 + the taller child, and its
+            stored size 1 + the sizes of both children **/
+  template <class T>
+  static void updateHeight(const std::shared_ptr<BinaryNode<T>> &node_ptr);
+
+  /** @pre node_ptr has a right child
+      @return the right child, now the root of the subtree **/
+  template <class T>
+  static std::shared_ptr<BinaryNode<T>> rotateLeft(std::shared_ptr<BinaryNode<T>> node_ptr);
+
+  /** @param unshare called on the right child before it is changed
+      @return unshare(right child), now the root of the subtree **/
+  template <class T, class Unshare>
+  static std::shared_ptr<BinaryNode<T>> rotateLeft(std::shared_ptr<BinaryNode<T>> node_ptr, const Unshare &unshare);
+
+  /** @pre node_ptr has a left child
+      @return the left child, now the root of the subtree **/
+  template <class T>
+  static std::shared_ptr<BinaryNode<T>> rotateRight(std::shared_ptr<BinaryNode<T>> node_ptr);
+
+  /** @param unshare called on the left child before it is changed
+      @return unshare(left child), now the root of the subtree **/
+  template <class T, class Unshare>
+  static std::shared_ptr<BinaryNode<T>> rotateRight(std::shared_ptr<BinaryNode<T>> node_ptr, const Unshare &unshare);
+
+private:
+  /** Unshare for trees that never share nodes **/
+  struct KeepNode
+  {
+    template <class T>
+    const std::shared_ptr<BinaryNode<T>> &operator()(const std::shared_ptr<BinaryNode<T>> &node_ptr) const
+    {
+      return node_ptr;
+    }
+  };
+};
+
+#include "BalancePolicy.cpp"
+#endif
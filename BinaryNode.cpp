@@ -5,25 +5,67 @@
 /** @file BinaryNode.cpp */
 
 #include "BinaryNode.hpp"
+#include <algorithm>
 #include <cstddef>
+#include <utility>
+#include <vector>
 
 template<class T>
 BinaryNode<T>::BinaryNode()
-      : item(nullptr), leftChildPtr(nullptr), rightChildPtr(nullptr)
+      : item(nullptr), leftChildPtr(nullptr), rightChildPtr(nullptr), height(1), size(ItemWeight<T>::of(item)), owner(0)
 { }  // end default constructor
 
 template<class T>
 BinaryNode<T>::BinaryNode(const T& anItem)
-      : item(anItem), leftChildPtr(nullptr), rightChildPtr(nullptr)
+      : item(anItem), leftChildPtr(nullptr), rightChildPtr(nullptr), height(1), size(ItemWeight<T>::of(item)), owner(0)
 { }  // end constructor
 
+template<class T>
+BinaryNode<T>::BinaryNode(T&& anItem)
+      : item(std::move(anItem)), leftChildPtr(nullptr), rightChildPtr(nullptr), height(1), size(ItemWeight<T>::of(item)), owner(0)
+{ }  // end move constructor
+
+template<class T>
+template<class... Args>
+BinaryNode<T>::BinaryNode(std::in_place_t, Args&&... args)
+      : item(std::forward<Args>(args)...), leftChildPtr(nullptr), rightChildPtr(nullptr), height(1), size(ItemWeight<T>::of(item)), owner(0)
+{ }  // end in-place constructor
+
 template<class T>
 BinaryNode<T>::BinaryNode(const T& anItem,
                                     std::shared_ptr<BinaryNode<T>> leftPtr,
                                     std::shared_ptr<BinaryNode<T>> rightPtr)
-      : item(anItem), leftChildPtr(leftPtr), rightChildPtr(rightPtr)
+      : item(anItem), leftChildPtr(std::move(leftPtr)), rightChildPtr(std::move(rightPtr)), height(1), size(ItemWeight<T>::of(item)), owner(0)
 { }  // end constructor
 
+template<class T>
+BinaryNode<T>::~BinaryNode()
+{
+   if (leftChildPtr == nullptr && rightChildPtr == nullptr)
+      return;
+   // Releasing the last owner of a subtree would destroy it recursively, so
+   // children are parked on a per-thread list and the outermost destructor
+   // lets go of them one at a time. Each release goes through shared_ptr's
+   // own count, which orders it after every other owner's, so a subtree
+   // still held by a snapshot on another thread is left alone
+   thread_local std::vector<std::shared_ptr<BinaryNode<T>>> pending;
+   thread_local bool draining = false;
+   if (leftChildPtr != nullptr)
+      pending.push_back(std::move(leftChildPtr));
+   if (rightChildPtr != nullptr)
+      pending.push_back(std::move(rightChildPtr));
+   if (draining)
+      return;
+   draining = true;
+   while (!pending.empty())
+   {
+      std::shared_ptr<BinaryNode<T>> node = std::move(pending.back());
+      pending.pop_back();
+      node.reset();  // may park its own children
+   }  // end while
+   draining = false;
+}  // end destructor
+
 template<class T>
 void BinaryNode<T>::setItem(const T& anItem)
 {
@@ -31,7 +73,13 @@ void BinaryNode<T>::setItem(const T& anItem)
 }  // end setItem
 
 template<class T>
-T BinaryNode<T>::getItem() const
+void BinaryNode<T>::setItem(T&& anItem)
+{
+   item = std::move(anItem);
+}  // end setItem
+
+template<class T>
+const T& BinaryNode<T>::getItem() const
 {
    return item;
 }  // end getItem
@@ -42,26 +90,72 @@ bool BinaryNode<T>::isLeaf() const
    return ((leftChildPtr == nullptr) && (rightChildPtr == nullptr));
 }
 
+template<class T>
+int BinaryNode<T>::getHeight() const
+{
+   return height;
+}  // end getHeight
+
+template<class T>
+void BinaryNode<T>::setHeight(int newHeight)
+{
+   height = newHeight;
+}  // end setHeight
+
+template<class T>
+int BinaryNode<T>::getSize() const
+{
+   return size;
+}  // end getSize
+
+template<class T>
+void BinaryNode<T>::setSize(int newSize)
+{
+   size = newSize;
+}  // end setSize
+
+template<class T>
+void BinaryNode<T>::updateCounts()
+{
+   int leftHeight = (leftChildPtr == nullptr) ? 0 : leftChildPtr->height;
+   int rightHeight = (rightChildPtr == nullptr) ? 0 : rightChildPtr->height;
+   height = 1 + std::max(leftHeight, rightHeight);
+   size = ItemWeight<T>::of(item) + ((leftChildPtr == nullptr) ? 0 : leftChildPtr->size)
+            + ((rightChildPtr == nullptr) ? 0 : rightChildPtr->size);
+}  // end updateCounts
+
 template<class T>
 void BinaryNode<T>::setLeftChildPtr(std::shared_ptr<BinaryNode<T>> leftPtr)
 {
-   leftChildPtr = leftPtr;
+   leftChildPtr = std::move(leftPtr);
 }  // end setLeftChildPtr
 
 template<class T>
 void BinaryNode<T>::setRightChildPtr(std::shared_ptr<BinaryNode<T>> rightPtr)
 {
-   rightChildPtr = rightPtr;
+   rightChildPtr = std::move(rightPtr);
 }  // end setRightChildPtr
 
 template<class T>
-std::shared_ptr<BinaryNode<T>> BinaryNode<T>::getLeftChildPtr() const
+std::uint64_t BinaryNode<T>::getOwner() const
+{
+   return owner;
+}  // end getOwner
+
+template<class T>
+void BinaryNode<T>::setOwner(std::uint64_t newOwner)
+{
+   owner = newOwner;
+}  // end setOwner
+
+template<class T>
+const std::shared_ptr<BinaryNode<T>>& BinaryNode<T>::getLeftChildPtr() const
 {
    return leftChildPtr;
 }  // end getLeftChildPtr		
 
 template<class T>
-std::shared_ptr<BinaryNode<T>> BinaryNode<T>::getRightChildPtr() const
+const std::shared_ptr<BinaryNode<T>>& BinaryNode<T>::getRightChildPtr() const
 {
    return rightChildPtr;
 }  // end getRightChildPtr		
@@ -9,7 +9,21 @@
 #ifndef BINARY_NODE_
 #define BINARY_NODE_
 
+#include <cstdint>
 #include <memory>
+#include <utility>
+
+/** How many entries an item counts for in the subtree sizes a node
+ stores: 1 unless specialized. A specialization lets one node stand for
+ several equal entries (MasteryIndex counts recipes per difficulty level
+ this way); getNumberOfNodes, select and rank then count weights. Only
+ BinarySearchTree::replace may swap an item for one of another weight; a
+ plain setItem has to keep it. **/
+template<class T>
+struct ItemWeight
+{
+   static int of(const T&) { return 1; }
+}; // end ItemWeight
 
 template<class T>
 class BinaryNode
@@ -18,19 +32,40 @@ private:
    T item;           // Data portion
    std::shared_ptr<BinaryNode<T>> leftChildPtr;   // Pointer to left child
    std::shared_ptr<BinaryNode<T>> rightChildPtr;  // Pointer to right child
+   int height;       // Height of the subtree rooted here
+   int size;         // Number of entries in the subtree rooted here (see ItemWeight)
+   std::uint64_t owner; // Tag of the tree edit allowed to change this node in place
 
 public:
    BinaryNode();
    BinaryNode(const T& anItem);
+   BinaryNode(T&& anItem);
+   template<class... Args>
+   explicit BinaryNode(std::in_place_t, Args&&... args); // builds the item from a T constructor's arguments
    BinaryNode(const T& anItem, std::shared_ptr<BinaryNode<T>> leftPtr, std::shared_ptr<BinaryNode<T>> rightPtr);
+   BinaryNode(const BinaryNode<T>&) = default;
+   BinaryNode<T>& operator=(const BinaryNode<T>&) = default;
+   ~BinaryNode(); // frees a chain of descendants without recursing down it
 
    void setItem(const T& anItem);
-   T getItem() const;
+   void setItem(T&& anItem);
+   const T& getItem() const;
    
    bool isLeaf() const;
 
-   std::shared_ptr<BinaryNode<T>> getLeftChildPtr() const;
-   std::shared_ptr<BinaryNode<T>> getRightChildPtr() const;
+   int getHeight() const;
+   void setHeight(int newHeight);
+
+   int getSize() const;
+   void setSize(int newSize);
+
+   void updateCounts(); // recomputes height and size from the children's
+
+   std::uint64_t getOwner() const;
+   void setOwner(std::uint64_t newOwner);
+
+   const std::shared_ptr<BinaryNode<T>>& getLeftChildPtr() const;
+   const std::shared_ptr<BinaryNode<T>>& getRightChildPtr() const;
    
    void setLeftChildPtr(std::shared_ptr<BinaryNode<T>> leftPtr);
    void setRightChildPtr(std::shared_ptr<BinaryNode<T>> rightPtr);
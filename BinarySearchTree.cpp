@@ -1,60 +1,134 @@
 #include "BinarySearchTree.hpp"
+#include "TreeTraversal.hpp"
+#include <algorithm>
+#include <atomic>
 #include <vector>
 
 
 /*CONSTRUCTRS*/
 
-template <class T>
-BinarySearchTree<T>::BinarySearchTree() : root_ptr_(nullptr)
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::BinarySearchTree() : root_ptr_(nullptr)
 {
 } // end default constructor
 
-template <class T>
-BinarySearchTree<T>::BinarySearchTree(const T &root_item)
-    : root_ptr_(std::make_shared<BinaryNode<T>>(root_item, nullptr, nullptr))
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::BinarySearchTree(const T &root_item)
+    : root_ptr_(nullptr)
 {
+  root_ptr_ = makeNode(root_item);
 } // end constructor
 
-template <class T>
-BinarySearchTree<T>::BinarySearchTree(const BinarySearchTree &another_tree)
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::BinarySearchTree(const BinarySearchTree &another_tree)
 {
   root_ptr_ = copyTree(another_tree.root_ptr_); // Call helper method
 } // end copy constructor
 
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::BinarySearchTree(BinarySearchTree &&another_tree)
+    : root_ptr_(std::move(another_tree.root_ptr_)), node_alloc_(another_tree.node_alloc_), owner_(another_tree.owner_)
+{
+  another_tree.root_ptr_ = nullptr;
+} // end move constructor
+
+/** @post this tree holds copies of the items of another_tree, in O(n) **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy> &BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::operator=(const BinarySearchTree &another_tree)
+{
+  if (this != &another_tree)
+    root_ptr_ = copyTree(another_tree.root_ptr_);
+  return *this;
+} // end copy assignment
+
+/** @post this tree holds the nodes of another_tree, which is left empty **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy> &BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::operator=(BinarySearchTree &&another_tree)
+{
+  if (this != &another_tree)
+  {
+    root_ptr_ = std::move(another_tree.root_ptr_);
+    another_tree.root_ptr_ = nullptr;
+    node_alloc_ = another_tree.node_alloc_; // the nodes keep their own storage alive
+    owner_ = another_tree.owner_;
+  }
+  return *this;
+} // end move assignment
+
 
 
 /*PUBLIC METHODS*/
 
+/** @return a tree holding the same items, in O(1); the two trees share
+            their nodes and copy them before changing them from now on **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::snapshot()
+{
+  BinarySearchTree shared_tree;
+  shared_tree.shareFrom(*this);
+  return shared_tree;
+} // end snapshot
+
  /** @return root_ptr_ **/
-template <class T>
-std::shared_ptr<BinaryNode<T>> BinarySearchTree<T>::getRoot() const
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::getRoot() const
 {
   return root_ptr_;
 }
 
 /** @return true if the BinarySearchTree is emtpy, false otherwise **/
-template <class T>
-bool BinarySearchTree<T>::isEmpty() const
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+bool BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::isEmpty() const
 {
   return root_ptr_ == nullptr;
 } // end isEmpty
 
 
-/** @return the height of the BST structure as the number of nodes on the longest path from root to leaf**/
-template <class T>
-int BinarySearchTree<T>::getHeight() const
+/** @return the height of the BST structure as the number of nodes on the longest path from root to leaf, in O(1)**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+int BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::getHeight() const
 {
-  return this->getHeightHelper(root_ptr_); // Call helper method
+  return root_ptr_ == nullptr ? 0 : root_ptr_->getHeight(); // kept up to date by every change
 } // end getHeight
 
 
-/** @return the number of Nodes in the BST structure**/
-template <class T>
-int BinarySearchTree<T>::getNumberOfNodes() const
+/** @return the number of Nodes in the BST structure, in O(1)**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+int BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::getNumberOfNodes() const
 {
-  return this->getNumberOfNodesHelper(root_ptr_); // Call helper method
+  return root_ptr_ == nullptr ? 0 : root_ptr_->getSize(); // kept up to date by every change
 } // end getNumberOfNodes
 
+/** @param predicate called with every item, possibly on several threads at once
+    @return the number of items for which predicate returns true **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class Predicate>
+int BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::countIf(Predicate predicate) const
+{
+  return countIf(root_ptr_, predicate);
+} // end countIf
+
+/** @param subtree_ptr the root of a subtree of this tree
+    @param predicate called with every item of the subtree, possibly on several threads at once
+    @return the number of items of the subtree for which predicate returns true **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class Predicate>
+int BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::countIf(const std::shared_ptr<BinaryNode<T>> &subtree_ptr, Predicate predicate) const
+{
+  auto serial = [&predicate](const std::shared_ptr<BinaryNode<T>> &serial_ptr) {
+    int count = 0;
+    preorderTraverse(serial_ptr, [&predicate, &count](const std::shared_ptr<BinaryNode<T>> &node_ptr) {
+      if (predicate(static_cast<const T &>(node_ptr->getItem())))
+        count++;
+    });
+    return count;
+  };
+  auto combine = [&predicate](const BinaryNode<T> *node, int left_count, int right_count) {
+    return (predicate(static_cast<const T &>(node->getItem())) ? 1 : 0) + left_count + right_count;
+  };
+  return forkJoin<int>(subtree_ptr, serial, combine);
+} // end countIf
+
 
 /** @param a new entry to be added to the BST
     @post new entry is added to the BST retaining the
@@ -63,40 +137,546 @@ int BinarySearchTree<T>::getNumberOfNodes() const
               and all items in its right subtree are > 
               Note: > and < would need to be overloaded for self made data types
     **/
-template <class T>
-void BinarySearchTree<T>::add(const T &new_entry)
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+void BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::add(const T &new_entry)
+{
+  std::shared_ptr<BinaryNode<T>> new_node_ptr = makeNode(new_entry);
+  root_ptr_ = placeNode(root_ptr_, new_node_ptr);
+} // end add
+
+/** @param new_entry an entry to be moved into the BST
+    @post same as add(const T&), without copying new_entry**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+void BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::add(T &&new_entry)
 {
-  std::shared_ptr<BinaryNode<T>> new_node_ptr = std::make_shared<BinaryNode<T>>(new_entry);
+  std::shared_ptr<BinaryNode<T>> new_node_ptr = makeNode(std::move(new_entry));
   root_ptr_ = placeNode(root_ptr_, new_node_ptr);
 } // end add
 
+/** @param new_entry an entry to be added if no entry with the same key exists
+    @post new_entry is added in the same single descent that checks for it
+    @return the node holding the entry with new_entry's key, and true if
+            new_entry was added, false if an entry with that key was already there**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+std::pair<std::shared_ptr<BinaryNode<T>>, bool> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::tryInsert(const T &new_entry)
+{
+  std::pair<std::shared_ptr<BinaryNode<T>>, bool> result(nullptr, false);
+  auto make_node = [this, &new_entry]() { return makeNode(new_entry); };
+  root_ptr_ = insertUnique(root_ptr_, KeyPolicy::key(new_entry), make_node, result);
+  return result;
+} // end tryInsert
+
+/** @param new_entry an entry to be moved in if no entry with the same key exists
+    @post same as tryInsert(const T&); new_entry is only moved from if it was added
+    @return same as tryInsert(const T&)**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+std::pair<std::shared_ptr<BinaryNode<T>>, bool> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::tryInsert(T &&new_entry)
+{
+  std::pair<std::shared_ptr<BinaryNode<T>>, bool> result(nullptr, false);
+  auto make_node = [this, &new_entry]() { return makeNode(std::move(new_entry)); };
+  root_ptr_ = insertUnique(root_ptr_, KeyPolicy::key(new_entry), make_node, result);
+  return result;
+} // end tryInsert
+
+/** @param args the arguments of a T constructor
+    @post the entry is built straight into a new node, which is linked in
+          if no entry with the same key exists and released otherwise
+    @return same as tryInsert(const T&)**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class... Args>
+std::pair<std::shared_ptr<BinaryNode<T>>, bool> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::emplace(Args &&...args)
+{
+  // The key lives in the entry, so the node has to exist before the descent
+  std::shared_ptr<BinaryNode<T>> new_node_ptr =
+      std::allocate_shared<BinaryNode<T>>(node_alloc_, std::in_place, std::forward<Args>(args)...);
+  new_node_ptr->setOwner(owner_);
+  std::pair<std::shared_ptr<BinaryNode<T>>, bool> result(nullptr, false);
+  auto make_node = [&new_node_ptr]() { return new_node_ptr; };
+  root_ptr_ = insertUnique(root_ptr_, KeyPolicy::key(new_node_ptr->getItem()), make_node, result);
+  return result;
+} // end emplace
+
 
   /** @param entry to be removed from the BST
       @post entry is removed from the BST and retaining its
               BST property, s.t. at any node, all Nodes in
               its left subtree are < the item at that node
               and all items in its right subtree are >**/
-template <class T>
-bool BinarySearchTree<T>::remove(const T &entry)
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+bool BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::remove(const T &entry)
 {
-  bool is_successful = false;
-  // call may change is_successful
-  root_ptr_ = removeValue(root_ptr_, entry, is_successful);
-  return is_successful;
+  std::shared_ptr<BinaryNode<T>> removed;
+  // call may set removed
+  root_ptr_ = removeValue(root_ptr_, KeyPolicy::key(entry), removed);
+  return removed != nullptr;
 } // end remove
 
+/** @param key the key of the entry to be removed, of any type that
+            compares with KeyPolicy::key(item)
+    @post same as remove(entry) for the entry with that key
+    @return true if an entry was removed**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class K>
+bool BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::erase(const K &key)
+{
+  return extract(key) != nullptr;
+} // end erase
+
+/** @param key the key of the entry to be removed, of any type that
+            compares with KeyPolicy::key(item)
+    @post same as erase(key)
+    @return the unlinked node that held the entry, nullptr if not found**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class K>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::extract(const K &key)
+{
+  std::shared_ptr<BinaryNode<T>> removed;
+  root_ptr_ = removeValue(root_ptr_, key, removed);
+  return removed;
+} // end extract
+
 
   /** @param entry to be found in the BST
       @return true if entry is found in the BST, false otherwise**/
-template <class T>
-bool BinarySearchTree<T>::contains(const T &entry) const
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+bool BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::contains(const T &entry) const
 {
-  return (findNode(root_ptr_, entry) != nullptr);
+  return (findNode(root_ptr_, KeyPolicy::key(entry)) != nullptr);
 } // end contains
 
+/** @param key a key of any type that compares with KeyPolicy::key(item)
+    @return true if an entry with that key is in the BST**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class K>
+bool BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::contains(const K &key) const
+{
+  return (findNode(root_ptr_, key) != nullptr);
+} // end contains
+
+/** @param key a key of any type that compares with KeyPolicy::key(item)
+    @return a pointer to the node holding the entry with that key, nullptr if not found**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class K>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::find(const K &key) const
+{
+  return findNode(root_ptr_, key);
+} // end find
+
+/** @param key a key of any type that compares with KeyPolicy::key(item)
+    @return the entry with that key, nullptr if not found; no reference
+            count is touched on the way down **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class K>
+const T *BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::findItem(const K &key) const
+{
+  const BinaryNode<T> *node = root_ptr_.get();
+  while (node != nullptr)
+  {
+    if (keyLess(key, KeyPolicy::key(node->getItem())))
+      node = node->getLeftChildPtr().get();
+    else if (keyLess(KeyPolicy::key(node->getItem()), key))
+      node = node->getRightChildPtr().get();
+    else
+      return &node->getItem();
+  }
+  return nullptr;
+} // end findItem
+
+/** @param first, last keys of any type that compares with KeyPolicy::key(item)
+    @param out receives, for each key in order, the entry with that key or nullptr
+    @return out past the last result **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class ForwardIt, class OutputIt>
+OutputIt BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::findBatch(ForwardIt first, ForwardIt last,
+                                                                                 OutputIt out) const
+{
+  ForwardIt keys[kBatchWidth];
+  const BinaryNode<T> *nodes[kBatchWidth]; // where each search is; nullptr once it is done
+  const T *found[kBatchWidth];
+  while (first != last)
+  {
+    std::size_t width = 0;
+    for (; width < kBatchWidth && first != last; ++first, ++width)
+    {
+      keys[width] = first;
+      nodes[width] = root_ptr_.get();
+      found[width] = nullptr;
+    }
+    // Each round takes every unfinished search one level down and asks for
+    // the node it lands on, so by the time the round comes back to a search
+    // its node is usually already in cache
+    bool searching = true;
+    while (searching)
+    {
+      searching = false;
+      for (std::size_t i = 0; i < width; i++)
+      {
+        const BinaryNode<T> *node = nodes[i];
+        if (node == nullptr)
+          continue;
+        if (keyLess(*keys[i], KeyPolicy::key(node->getItem())))
+          node = node->getLeftChildPtr().get();
+        else if (keyLess(KeyPolicy::key(node->getItem()), *keys[i]))
+          node = node->getRightChildPtr().get();
+        else
+        {
+          found[i] = &node->getItem();
+          node = nullptr;
+        }
+        nodes[i] = node;
+        if (node != nullptr)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+          __builtin_prefetch(node);
+#endif
+          searching = true;
+        }
+      }
+    }
+    for (std::size_t i = 0; i < width; i++)
+      *out++ = found[i];
+  }
+  return out;
+} // end findBatch
+
+/** @param key a key of any type that compares with KeyPolicy::key(item)
+    @return the node holding the entry with that key, nullptr if not found;
+            its item may be replaced through setItem as long as the key
+            stays the same. If the node is shared with a snapshot, it and the
+            path above it are copied first. **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class K>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::findForUpdate(const K &key)
+{
+  std::shared_ptr<BinaryNode<T>> found = findNode(root_ptr_, key);
+  if (found == nullptr || found->getOwner() == owner_)
+    return found; // a node this tree owns has only owned nodes above it
+  root_ptr_ = ownNode(root_ptr_);
+  const std::shared_ptr<BinaryNode<T>> *link = &root_ptr_;
+  while (true)
+  {
+    BinaryNode<T> *node = link->get();
+    if (keyLess(key, KeyPolicy::key(node->getItem())))
+    {
+      node->setLeftChildPtr(ownNode(node->getLeftChildPtr()));
+      link = &node->getLeftChildPtr();
+    }
+    else if (keyLess(KeyPolicy::key(node->getItem()), key))
+    {
+      node->setRightChildPtr(ownNode(node->getRightChildPtr()));
+      link = &node->getRightChildPtr();
+    }
+    else
+      return *link;
+  }
+} // end findForUpdate
+
+/** @param new_entry an entry to take the place of the one with its key
+    @post the entry is replaced and the sizes above it are up to date
+    @return the node now holding new_entry, nullptr if not found **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::replace(T new_entry)
+{
+  if (findNode(root_ptr_, KeyPolicy::key(new_entry)) == nullptr)
+    return nullptr; // nothing on the way down is copied for nothing
+  // Own the whole path, so its stored sizes can be changed in place; the
+  // shape stays the same, so nothing is rebalanced
+  root_ptr_ = ownNode(root_ptr_);
+  const std::shared_ptr<BinaryNode<T>> *link = &root_ptr_;
+  while (true)
+  {
+    BinaryNode<T> *node = link->get();
+    bool went_left = keyLess(KeyPolicy::key(new_entry), KeyPolicy::key(node->getItem()));
+    if (!went_left && !keyLess(KeyPolicy::key(node->getItem()), KeyPolicy::key(new_entry)))
+      break;
+    path_.push_back(PathStep{link, went_left});
+    if (went_left)
+    {
+      node->setLeftChildPtr(ownNode(node->getLeftChildPtr()));
+      link = &node->getLeftChildPtr();
+    }
+    else
+    {
+      node->setRightChildPtr(ownNode(node->getRightChildPtr()));
+      link = &node->getRightChildPtr();
+    }
+  }
+  std::shared_ptr<BinaryNode<T>> found = *link;
+  found->setItem(std::move(new_entry));
+  found->updateCounts();
+  while (!path_.empty())
+  {
+    (*path_.back().link)->updateCounts();
+    path_.pop_back();
+  }
+  return found;
+} // end replace
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+typename BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::begin() const
+{
+  const_iterator first;
+  first.root_ = root_ptr_.get();
+  first.pushLeftSpine(root_ptr_.get());
+  return first;
+} // end begin
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+typename BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::end() const
+{
+  const_iterator last;
+  last.root_ = root_ptr_.get();
+  return last;
+} // end end
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class K>
+typename BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::lower_bound(const K &key) const
+{
+  return boundFor(key, true);
+} // end lower_bound
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class K>
+typename BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::upper_bound(const K &key) const
+{
+  return boundFor(key, false);
+} // end upper_bound
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class K>
+typename BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::Range BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::range(const K &lo, const K &hi) const
+{
+  if (keyLess(hi, lo))
+    return Range(end(), end());
+  return Range(boundFor(lo, true), boundFor(hi, false));
+} // end range
+
+/** @param k a position in key order, counted from 0
+    @return an iterator to the item with k smaller items, end() if k is
+            not less than getNumberOfNodes(); found in one descent **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+typename BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::select(std::size_t k) const
+{
+  // The stored sizes tell which side of each node position k lies on
+  const_iterator selected;
+  selected.root_ = root_ptr_.get();
+  const BinaryNode<T> *node = root_ptr_.get();
+  while (node != nullptr)
+  {
+    selected.path_.push_back(node);
+    const BinaryNode<T> *left = node->getLeftChildPtr().get();
+    std::size_t left_size = left == nullptr ? 0 : left->getSize();
+    std::size_t weight = ItemWeight<T>::of(node->getItem());
+    if (k < left_size)
+      node = left;
+    else if (k < left_size + weight)
+      return selected;
+    else
+    {
+      k -= left_size + weight;
+      node = node->getRightChildPtr().get();
+    }
+  }
+  selected.path_.clear(); // k is past the last item
+  return selected;
+} // end select
+
+/** @param key a key of any type that compares with KeyPolicy::key(item)
+    @return the number of items whose key is less than key, which is the
+            position of the item with that key if there is one **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class K>
+std::size_t BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::rank(const K &key) const
+{
+  // Every time the search turns right, the node and its left subtree are smaller
+  std::size_t smaller = 0;
+  const BinaryNode<T> *node = root_ptr_.get();
+  while (node != nullptr)
+  {
+    const BinaryNode<T> *left = node->getLeftChildPtr().get();
+    if (keyLess(KeyPolicy::key(node->getItem()), key))
+    {
+      smaller += ItemWeight<T>::of(node->getItem()) + (left == nullptr ? 0 : left->getSize());
+      node = node->getRightChildPtr().get();
+    }
+    else
+      node = left;
+  }
+  return smaller;
+} // end rank
+
+/** @param first, last a range of entries sorted by key with no two equal keys
+    @post the BST holds exactly those entries, moved out of the range into
+          a perfectly balanced tree built in O(n)**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class ForwardIt>
+void BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::buildFromSorted(ForwardIt first, ForwardIt last)
+{
+  clear();
+  mergeSorted(first, last);
+} // end buildFromSorted
+
+/** @param first, last a range of entries sorted by key with no two equal keys
+    @post entries whose key is not in the BST yet are moved in, and the
+          whole BST is rebuilt perfectly balanced in O(n + m); existing
+          nodes are relinked, not copied
+    @return the number of entries added**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class ForwardIt>
+std::size_t BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::mergeSorted(ForwardIt first, ForwardIt last)
+{
+  return mergeSorted(first, last, [](const std::shared_ptr<BinaryNode<T>> &) {});
+} // end mergeSorted
+
+/** @param on_added called with the node of every entry that was added
+    @post same as mergeSorted(first, last)
+    @return the number of entries added**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class ForwardIt, class OnAdded>
+std::size_t BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::mergeSorted(ForwardIt first, ForwardIt last, OnAdded on_added)
+{
+  // First pass: count the merged size, so the shape can be fixed up front
+  std::size_t existing = 0, added = 0;
+  {
+    InorderCursor cursor(root_ptr_);
+    ForwardIt it = first;
+    while (!cursor.done() || it != last)
+    {
+      if (it == last || (!cursor.done() && keyLess(KeyPolicy::key(cursor.peek()->getItem()), KeyPolicy::key(*it))))
+      {
+        cursor.next();
+        existing++;
+      }
+      else if (cursor.done() || keyLess(KeyPolicy::key(*it), KeyPolicy::key(cursor.peek()->getItem())))
+      {
+        ++it;
+        added++;
+      }
+      else
+      {
+        // Same key: the entry already in the tree wins
+        cursor.next();
+        ++it;
+        existing++;
+      }
+    }
+  }
+  if (added == 0)
+    return 0;
+
+  // Second pass: hand the nodes over in key order, making nodes for new entries
+  InorderCursor cursor(root_ptr_);
+  auto next_node = [&]() -> std::shared_ptr<BinaryNode<T>> {
+    while (true)
+    {
+      if (first == last || (!cursor.done() && keyLess(KeyPolicy::key(cursor.peek()->getItem()), KeyPolicy::key(*first))))
+        return ownNode(cursor.next()); // its links are about to be overwritten
+      if (cursor.done() || keyLess(KeyPolicy::key(*first), KeyPolicy::key(cursor.peek()->getItem())))
+      {
+        std::shared_ptr<BinaryNode<T>> node_ptr = makeNode(std::move(*first));
+        ++first;
+        on_added(node_ptr);
+        return node_ptr;
+      }
+      ++first; // same key, skip the new entry
+    }
+  };
+  root_ptr_ = buildBalanced(existing + added, next_node);
+  return added;
+} // end mergeSorted
+
+/** @param put_first, put_last entries sorted by key with no two equal keys
+    @param erase_first, erase_last keys sorted with no two equal, none of them the key of an entry to put
+    @param on_removed called with every entry that leaves the BST
+    @return the number of entries the BST now holds**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class PutIt, class EraseIt, class OnRemoved>
+std::size_t BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::mergeEdits(PutIt put_first, PutIt put_last,
+                                                                                     EraseIt erase_first, EraseIt erase_last,
+                                                                                     OnRemoved on_removed)
+{
+  // One pass lines the kept and new nodes up in key order. Unlike
+  // mergeSorted, which counts in a first pass, this compares every key once
+  // only, at the price of a pointer per node
+  std::vector<std::shared_ptr<BinaryNode<T>>> merged;
+  merged.reserve(getNumberOfNodes() + std::distance(put_first, put_last));
+  InorderCursor cursor(root_ptr_);
+  while (!cursor.done() || put_first != put_last)
+  {
+    if (put_first == put_last ||
+        (!cursor.done() && keyLess(KeyPolicy::key(cursor.peek()->getItem()), KeyPolicy::key(*put_first))))
+    {
+      const auto &key = KeyPolicy::key(cursor.peek()->getItem());
+      while (erase_first != erase_last && keyLess(*erase_first, key))
+        ++erase_first;
+      if (erase_first == erase_last || keyLess(key, *erase_first))
+        merged.push_back(ownNode(cursor.next())); // its links are about to be overwritten
+      else
+        on_removed(cursor.next()->getItem());
+      continue;
+    }
+    if (!cursor.done() && !keyLess(KeyPolicy::key(*put_first), KeyPolicy::key(cursor.peek()->getItem())))
+      on_removed(cursor.next()->getItem()); // same key, replaced
+    merged.push_back(makeNode(std::move(*put_first)));
+    ++put_first;
+  }
+
+  std::size_t next = 0;
+  auto next_node = [&]() -> std::shared_ptr<BinaryNode<T>> { return std::move(merged[next++]); };
+  root_ptr_ = buildBalanced(merged.size(), next_node);
+  return merged.size();
+} // end mergeEdits
+
+/** @post the BST is rebalanced by relinking its nodes (Day-Stout-Warren),
+          so every level but the last is full; no item is copied, nothing
+          is allocated and only O(log n) stack is used**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+void BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::balanceInPlace()
+{
+  ownAllNodes();
+  // Phase 1: right rotations turn the tree into a sorted vine of right children
+  std::size_t count = 0;
+  BinaryNode<T> *tail = nullptr; // last node already on the vine
+  std::shared_ptr<BinaryNode<T>> rest = root_ptr_;
+  while (rest != nullptr)
+  {
+    if (rest->getLeftChildPtr() != nullptr)
+    {
+      std::shared_ptr<BinaryNode<T>> left = rest->getLeftChildPtr();
+      rest->setLeftChildPtr(left->getRightChildPtr());
+      left->setRightChildPtr(rest);
+      rest = left;
+      if (tail == nullptr)
+        root_ptr_ = rest;
+      else
+        tail->setRightChildPtr(rest);
+    }
+    else
+    {
+      count++;
+      tail = rest.get();
+      rest = rest->getRightChildPtr();
+    }
+  }
+
+  // Phase 2: left rotations fold the vine; first the extra bottom-level nodes
+  std::size_t full = 1;
+  while (full * 2 <= count + 1)
+    full *= 2;
+  std::size_t leaves = count + 1 - full;
+  compressVine(nullptr, leaves);
+  for (std::size_t remaining = count - leaves; remaining > 1; )
+  {
+    remaining /= 2;
+    compressVine(nullptr, remaining);
+  }
+  restoreCounts(root_ptr_);
+} // end balanceInPlace
+
 /**Display preorder traversal through the BST**/
-template <class T>
-void BinarySearchTree<T>::displayPreorder()
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+void BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::displayPreorder()
 {
   preorderHelper(root_ptr_);
   std::cout << std::endl;
@@ -104,147 +684,510 @@ void BinarySearchTree<T>::displayPreorder()
 
 /**
  * @param: sets the root pointer to the parameter
+ * @post: the stored heights and sizes under it are recomputed, in O(n)
  */
-template <class T>
-void BinarySearchTree<T>::setRoot(std::shared_ptr<BinaryNode<T>> new_root_ptr)
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+void BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::setRoot(std::shared_ptr<BinaryNode<T>> new_root_ptr)
 {
   root_ptr_ = new_root_ptr;
+  restoreCounts(root_ptr_); // the nodes may have been linked by hand
 }
 
+/** @post the tree is empty; every node no other tree still holds is
+      destroyed, one at a time, in O(n), and its block goes back to the
+      node pool for later nodes (the pool's slabs are never released)**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+void BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::clear()
+{
+  root_ptr_ = nullptr;
+} // end clear
 
+/** @param item the item to store
+    @return a new leaf holding item, allocated from node_alloc_ **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::makeNode(const T &item) const
+{
+  std::shared_ptr<BinaryNode<T>> node_ptr = std::allocate_shared<BinaryNode<T>>(node_alloc_, item);
+  node_ptr->setOwner(owner_);
+  return node_ptr;
+} // end makeNode
+
+/** @param item the item to move into the node
+    @return a new leaf holding item, allocated from node_alloc_ **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::makeNode(T &&item) const
+{
+  std::shared_ptr<BinaryNode<T>> node_ptr = std::allocate_shared<BinaryNode<T>>(node_alloc_, std::move(item));
+  node_ptr->setOwner(owner_);
+  return node_ptr;
+} // end makeNode
+
+/** @param source the tree to share nodes with
+    @post this tree holds the same items as source, in O(1): both point at
+          the same nodes, and from now on each one copies a node (and the
+          path above it) before changing it, so neither sees the other's changes**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+void BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::shareFrom(BinarySearchTree &source)
+{
+  root_ptr_ = source.root_ptr_;
+  owner_ = newOwner();
+  source.owner_ = newOwner();
+} // end shareFrom
+
+
+
+
+
+/*PROTECTED METHODS*/
+
+/** @param count the number of nodes in the subtree to build
+    @param next_node called count times, returning the nodes in key order
+    @post the nodes are linked into a perfectly balanced subtree with
+          up-to-date heights; next_node may reuse nodes of the old tree, as
+          a node's links are only overwritten after it has been returned
+    @return a pointer to the root of the built subtree**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class NextNode>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::buildBalanced(std::size_t count, NextNode &next_node)
+{
+  if (count == 0)
+    return nullptr;
+  // Build in order: left subtree, then this node, then right subtree
+  std::size_t left_count = count / 2;
+  std::shared_ptr<BinaryNode<T>> left = buildBalanced(left_count, next_node);
+  std::shared_ptr<BinaryNode<T>> node_ptr = next_node();
+  std::shared_ptr<BinaryNode<T>> right = buildBalanced(count - left_count - 1, next_node);
+  node_ptr->setLeftChildPtr(std::move(left));
+  node_ptr->setRightChildPtr(std::move(right));
+  node_ptr->updateCounts();
+  return node_ptr;
+} // end buildBalanced
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::InorderCursor::InorderCursor(const std::shared_ptr<BinaryNode<T>> &root_ptr)
+{
+  pushLeftSpine(root_ptr);
+} // end constructor
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+bool BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::InorderCursor::done() const
+{
+  return stack_.empty();
+} // end done
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+const std::shared_ptr<BinaryNode<T>> &BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::InorderCursor::peek() const
+{
+  return stack_.back();
+} // end peek
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::InorderCursor::next()
+{
+  std::shared_ptr<BinaryNode<T>> node_ptr = std::move(stack_.back());
+  stack_.pop_back();
+  pushLeftSpine(node_ptr->getRightChildPtr());
+  return node_ptr;
+} // end next
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+void BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::InorderCursor::pushLeftSpine(const std::shared_ptr<BinaryNode<T>> &node_ptr)
+{
+  // Followed by reference, so each node's count is touched once, by its push
+  const std::shared_ptr<BinaryNode<T>> *link = &node_ptr;
+  while (*link != nullptr)
+  {
+    stack_.push_back(*link);
+    link = &(*link)->getLeftChildPtr();
+  }
+} // end pushLeftSpine
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator::const_iterator() : root_(nullptr)
+{
+} // end default constructor
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+typename BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator::reference BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator::operator*() const
+{
+  return path_.back()->getItem();
+} // end operator*
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+typename BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator::pointer BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator::operator->() const
+{
+  return &path_.back()->getItem();
+} // end operator->
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+typename BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator &BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator::operator++()
+{
+  const BinaryNode<T> *node = path_.back();
+  if (node->getRightChildPtr() != nullptr)
+  {
+    pushLeftSpine(node->getRightChildPtr().get());
+    return *this;
+  }
+  // Climb until we come up out of a left subtree; that parent is next
+  path_.pop_back();
+  while (!path_.empty() && path_.back()->getRightChildPtr().get() == node)
+  {
+    node = path_.back();
+    path_.pop_back();
+  }
+  return *this;
+} // end operator++
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+typename BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator::operator++(int)
+{
+  const_iterator old = *this;
+  ++*this;
+  return old;
+} // end operator++
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+typename BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator &BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator::operator--()
+{
+  if (path_.empty())
+  {
+    pushRightSpine(root_);
+    return *this;
+  }
+  const BinaryNode<T> *node = path_.back();
+  if (node->getLeftChildPtr() != nullptr)
+  {
+    pushRightSpine(node->getLeftChildPtr().get());
+    return *this;
+  }
+  // Climb until we come up out of a right subtree; that parent is previous
+  path_.pop_back();
+  while (!path_.empty() && path_.back()->getLeftChildPtr().get() == node)
+  {
+    node = path_.back();
+    path_.pop_back();
+  }
+  return *this;
+} // end operator--
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+typename BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator::operator--(int)
+{
+  const_iterator old = *this;
+  --*this;
+  return old;
+} // end operator--
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+bool BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator::operator==(const const_iterator &other) const
+{
+  if (path_.empty() || other.path_.empty())
+    return path_.empty() && other.path_.empty();
+  return path_.back() == other.path_.back();
+} // end operator==
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+bool BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator::operator!=(const const_iterator &other) const
+{
+  return !(*this == other);
+} // end operator!=
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+void BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator::pushLeftSpine(const BinaryNode<T> *node)
+{
+  while (node != nullptr)
+  {
+    path_.push_back(node);
+    node = node->getLeftChildPtr().get();
+  }
+} // end pushLeftSpine
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+void BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator::pushRightSpine(const BinaryNode<T> *node)
+{
+  while (node != nullptr)
+  {
+    path_.push_back(node);
+    node = node->getRightChildPtr().get();
+  }
+} // end pushRightSpine
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::Range::Range(const_iterator first, const_iterator last)
+    : first_(std::move(first)), last_(std::move(last))
+{
+} // end constructor
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+typename BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::Range::begin() const
+{
+  return first_;
+} // end begin
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+typename BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::Range::end() const
+{
+  return last_;
+} // end end
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+bool BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::Range::empty() const
+{
+  return first_ == last_;
+} // end empty
 
 
 
 /*PRIVATE METHODS*/
 
 
-template <class T>
-void BinarySearchTree<T>::preorderHelper(std::shared_ptr<BinaryNode<T>> node)
+/** called by balanceInPlace
+      @param parent the vine node whose right link starts the run, nullptr for the root
+      @param count the number of left rotations to do down the right vine
+      @post every second node of the run is rotated up one level**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+void BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::compressVine(BinaryNode<T> *parent, std::size_t count)
 {
-  if (node == nullptr)
+  for (std::size_t i = 0; i < count; i++)
   {
-    return;
+    std::shared_ptr<BinaryNode<T>> child = parent == nullptr ? root_ptr_ : parent->getRightChildPtr();
+    std::shared_ptr<BinaryNode<T>> right = child->getRightChildPtr();
+    child->setRightChildPtr(right->getLeftChildPtr());
+    right->setLeftChildPtr(child);
+    if (parent == nullptr)
+      root_ptr_ = right;
+    else
+      parent->setRightChildPtr(right);
+    parent = right.get();
   }
-    std::cout << node->getItem() << " ";
-  preorderHelper(node->getLeftChildPtr());
-  preorderHelper(node->getRightChildPtr());
-}
+} // end compressVine
+
+
+/** called by balanceInPlace and setRoot
+      @param subtree_ptr a pointer to the root of a subtree
+      @post the height and size stored in every node of the subtree are correct**/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+void BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::restoreCounts(const std::shared_ptr<BinaryNode<T>> &subtree_ptr)
+{
+  postorderTraverse(subtree_ptr, [](const std::shared_ptr<BinaryNode<T>> &node_ptr) { node_ptr->updateCounts(); });
+} // end restoreCounts
+
+
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+void BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::preorderHelper(const std::shared_ptr<BinaryNode<T>> &node)
+{
+  preorderTraverse(node, [](const std::shared_ptr<BinaryNode<T>> &node_ptr) {
+    std::cout << node_ptr->getItem() << " ";
+  });
+} // end preorderHelper
 
 
  /** called by copy constructor
       @param old_tee_root_ptr a pointer to the root of the tree to be copied
-      @post recursively copies every node in the tree pointed to by the parameter pointer
+      @post copies every node in the tree pointed to by the parameter pointer;
+            large subtrees are copied in parallel, each task allocating from
+            its own thread's cache in the node pool
       @return a pointer to the root of the copied subtree
      **/
-template <class T>
-std::shared_ptr<BinaryNode<T>> BinarySearchTree<T>::copyTree(const std::shared_ptr<BinaryNode<T>> old_tee_root_ptr) const
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::copyTree(const std::shared_ptr<BinaryNode<T>> &old_tee_root_ptr) const
 {
-  std::shared_ptr<BinaryNode<T>> new_tree_ptr;
-
-  // Copy tree nodes during a preorder traversal
-  if (old_tee_root_ptr != nullptr)
-  {
-    // Copy node
-    new_tree_ptr = std::make_shared<BinaryNode<T>>(old_tee_root_ptr->getItem(), nullptr, nullptr);
-    new_tree_ptr->setLeftChildPtr(copyTree(old_tee_root_ptr->getLeftChildPtr()));
-    new_tree_ptr->setRightChildPtr(copyTree(old_tee_root_ptr->getRightChildPtr()));
-  } // end if
-
+  if (!shouldFork(old_tee_root_ptr))
+    return copySubtree(old_tee_root_ptr);
+  std::shared_ptr<BinaryNode<T>> new_tree_ptr = makeNode(old_tee_root_ptr->getItem());
+  new_tree_ptr->setHeight(old_tee_root_ptr->getHeight());
+  new_tree_ptr->setSize(old_tee_root_ptr->getSize());
+  ThreadPool::TaskGroup group(ThreadPool::shared());
+  group.run([this, &old_tee_root_ptr, &new_tree_ptr]() {
+    const std::shared_ptr<BinaryNode<T>> &old_left_ptr = old_tee_root_ptr->getLeftChildPtr();
+    // Both halves draw on the one node pool; each thread has its own cache
+    // of free blocks there and only locks the pool to refill it
+    new_tree_ptr->setLeftChildPtr(shouldFork(old_left_ptr) ? copyTree(old_left_ptr) : copySubtree(old_left_ptr));
+  });
+  const std::shared_ptr<BinaryNode<T>> &old_right_ptr = old_tee_root_ptr->getRightChildPtr();
+  new_tree_ptr->setRightChildPtr(shouldFork(old_right_ptr) ? copyTree(old_right_ptr) : copySubtree(old_right_ptr));
+  group.wait();
   return new_tree_ptr;
 } // end copyTree
 
-
-  /** called by getHeight
-     @param subtree_ptr a pointer to the root of the current subtree
-     @return the height of the BST structure
-     as the number of nodes on the longest path
-     from root to leaf**/
-template <class T>
-int BinarySearchTree<T>::getHeightHelper(std::shared_ptr<BinaryNode<T>> subtree_ptr) const
+/** @return true if the subtree is worth splitting across the thread pool **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+bool BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::shouldFork(const std::shared_ptr<BinaryNode<T>> &subtree_ptr)
 {
-  if (subtree_ptr == nullptr)
-    return 0;
-  else
-    return 1 + std::max(getHeightHelper(subtree_ptr->getLeftChildPtr()), getHeightHelper(subtree_ptr->getRightChildPtr()));
-} // end getHeightHelper
+  return subtree_ptr != nullptr && subtree_ptr->getSize() >= kParallelSize && ThreadPool::shared().getWorkerCount() > 0;
+} // end shouldFork
 
+/** called by countIf
+    @param serial returns the value of a subtree, walking it on this thread
+    @param combine returns the value of a subtree from its root and the
+           values of its left and right subtrees
+    @return the value of the subtree; while shouldFork, the left half is
+            forked onto the thread pool and the right half done here **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class Result, class Serial, class Combine>
+Result BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::forkJoin(const std::shared_ptr<BinaryNode<T>> &subtree_ptr, const Serial &serial, const Combine &combine)
+{
+  if (!shouldFork(subtree_ptr))
+    return serial(subtree_ptr);
+  Result left_result = Result();
+  ThreadPool::TaskGroup group(ThreadPool::shared());
+  group.run([&subtree_ptr, &serial, &combine, &left_result]() {
+    left_result = forkJoin<Result>(subtree_ptr->getLeftChildPtr(), serial, combine);
+  });
+  Result right_result = forkJoin<Result>(subtree_ptr->getRightChildPtr(), serial, combine);
+  group.wait();
+  return combine(subtree_ptr.get(), left_result, right_result);
+} // end forkJoin
 
-/** called by getNumberOfNodes
-     @param subtree_ptr a pointer to the root of the current subtree
-     @return the number of nodes in the tree**/
-template <class T>
-int BinarySearchTree<T>::getNumberOfNodesHelper(std::shared_ptr<BinaryNode<T>> subtree_ptr) const
+ /** called by copyTree
+      @post copies every node of the subtree on this thread, using an explicit stack
+      @return a pointer to the root of the copied subtree
+     **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::copySubtree(const std::shared_ptr<BinaryNode<T>> &old_tee_root_ptr) const
 {
-  if (subtree_ptr == nullptr)
-    return 0;
-  else
-    return 1 + getNumberOfNodesHelper(subtree_ptr->getLeftChildPtr()) + getNumberOfNodesHelper(subtree_ptr->getRightChildPtr());
-} // end getNumberOfNodesHelper
+  if (old_tee_root_ptr == nullptr)
+    return nullptr;
+
+  auto copy_node = [this](const BinaryNode<T> *old_node) {
+    std::shared_ptr<BinaryNode<T>> node_ptr = makeNode(old_node->getItem());
+    node_ptr->setHeight(old_node->getHeight());
+    node_ptr->setSize(old_node->getSize());
+    return node_ptr;
+  };
+  // Copy tree nodes during a preorder traversal, pairing each old node with its copy
+  std::shared_ptr<BinaryNode<T>> new_tree_ptr = copy_node(old_tee_root_ptr.get());
+  std::vector<std::pair<const BinaryNode<T> *, BinaryNode<T> *>> pending;
+  pending.push_back(std::make_pair(old_tee_root_ptr.get(), new_tree_ptr.get()));
+  while (!pending.empty())
+  {
+    const BinaryNode<T> *old_node = pending.back().first;
+    BinaryNode<T> *new_node = pending.back().second;
+    pending.pop_back();
+    if (old_node->getLeftChildPtr() != nullptr)
+    {
+      new_node->setLeftChildPtr(copy_node(old_node->getLeftChildPtr().get()));
+      pending.push_back(std::make_pair(old_node->getLeftChildPtr().get(), new_node->getLeftChildPtr().get()));
+    }
+    if (old_node->getRightChildPtr() != nullptr)
+    {
+      new_node->setRightChildPtr(copy_node(old_node->getRightChildPtr().get()));
+      pending.push_back(std::make_pair(old_node->getRightChildPtr().get(), new_node->getRightChildPtr().get()));
+    }
+  }
+  return new_tree_ptr;
+} // end copySubtree
 
 
 /** called by add(new_entry)
       @param subtree_ptr a pointer to the subtree in which to place the new node
       @param new_node_ptr a pointer to the new node to be added to the tree
-      @post recursively places the new node as a leaf retaining the BST property
+      @post places the new node as a leaf retaining the BST property
       @return a pointer to the root of the subtree in which node was placed
      **/
-template <class T>
-std::shared_ptr<BinaryNode<T>> BinarySearchTree<T>::placeNode(std::shared_ptr<BinaryNode<T>> subtree_ptr, std::shared_ptr<BinaryNode<T>> new_node_ptr)
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::placeNode(std::shared_ptr<BinaryNode<T>> subtree_ptr, std::shared_ptr<BinaryNode<T>> new_node_ptr)
 {
-  if (subtree_ptr == nullptr)
-    return new_node_ptr;
-  else
+  // Walk down to the empty link, recording the path for the way back up
+  std::size_t first_step = path_.size();
+  const std::shared_ptr<BinaryNode<T>> *link = &subtree_ptr;
+  while (*link != nullptr)
   {
-    if (subtree_ptr->getItem() > new_node_ptr->getItem())
-      subtree_ptr->setLeftChildPtr(placeNode(subtree_ptr->getLeftChildPtr(), new_node_ptr));
-    else
-      subtree_ptr->setRightChildPtr(placeNode(subtree_ptr->getRightChildPtr(), new_node_ptr));
-    return subtree_ptr;
+    bool went_left = keyLess(KeyPolicy::key(new_node_ptr->getItem()), KeyPolicy::key((*link)->getItem()));
+    path_.push_back(PathStep{link, went_left});
+    link = went_left ? &(*link)->getLeftChildPtr() : &(*link)->getRightChildPtr();
   }
+  return unwindPath(first_step, std::move(new_node_ptr));
 } // end placeNode
 
 
+/** called by tryInsert and emplace
+      @param subtree_ptr a pointer to the subtree in which to place the new entry
+      @param key the key of the new entry
+      @param make_node called once, only when key is absent, to get the node to link in
+      @param result set to the node holding key and whether it was added
+      @post places the new node as a leaf retaining the BST property,
+            rebalancing every subtree on the path back up
+      @return a pointer to the root of the subtree
+     **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class K, class MakeNode>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::insertUnique(std::shared_ptr<BinaryNode<T>> subtree_ptr, const K &key, MakeNode &make_node,
+    std::pair<std::shared_ptr<BinaryNode<T>>, bool> &result)
+{
+  std::size_t first_step = path_.size();
+  const std::shared_ptr<BinaryNode<T>> *link = &subtree_ptr;
+  while (*link != nullptr)
+  {
+    if (keyLess(key, KeyPolicy::key((*link)->getItem())))
+    {
+      path_.push_back(PathStep{link, true});
+      link = &(*link)->getLeftChildPtr();
+    }
+    else if (keyLess(KeyPolicy::key((*link)->getItem()), key))
+    {
+      path_.push_back(PathStep{link, false});
+      link = &(*link)->getRightChildPtr();
+    }
+    else
+    {
+      // Already there; nothing changes, so no rebalancing either
+      result.first = *link;
+      path_.resize(first_step);
+      return subtree_ptr;
+    }
+  }
+  result.first = make_node();
+  result.second = true;
+  return unwindPath(first_step, result.first);
+} // end insertUnique
+
+
     /** called by contains
       @param subtree_ptr a pointer to the subtree to be searched
-      @param target a reference to the item to be found
+      @param target a reference to the key to be found
       @return a pointer to the node containing the target, nullptr if not found
      **/
-template <class T>
-std::shared_ptr<BinaryNode<T>> BinarySearchTree<T>::findNode(std::shared_ptr<BinaryNode<T>> subtree_ptr, const T &target) const
-{
-  // Uses a binary search
-  if (subtree_ptr == nullptr)
-    return subtree_ptr; // Not found
-  else if ((subtree_ptr->getItem() == target))
-    return subtree_ptr; // Found
-  else if (subtree_ptr->getItem() > target)
-    // Search left subtree
-    return findNode(subtree_ptr->getLeftChildPtr(), target);
-  else
-    // Search right subtree
-    return findNode(subtree_ptr->getRightChildPtr(), target);
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class K>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::findNode(const std::shared_ptr<BinaryNode<T>> &subtree_ptr, const K &target) const
+{
+  // Uses a binary search, following links without copying them
+  const std::shared_ptr<BinaryNode<T>> *link = &subtree_ptr;
+  while (*link != nullptr)
+  {
+    if (keyLess(target, KeyPolicy::key((*link)->getItem())))
+      link = &(*link)->getLeftChildPtr(); // Search left subtree
+    else if (keyLess(KeyPolicy::key((*link)->getItem()), target))
+      link = &(*link)->getRightChildPtr(); // Search right subtree
+    else
+      return *link; // Found
+  }
+  return nullptr; // Not found
 } // end findNode
 
 
 /** called by removeNode
-      @param node_ptr a pointer to the node to be removed
-      @param inorder_successor a reference to the  inorder successor (the smallest value in the left subtree) of the node to be deleted
-      @post removes the node containing the inorder successor
-      @return a pointer to the subtree after inorder successor node has been deleted
+      @param node_ptr a pointer to the root of the right subtree of the node to be removed
+      @param inorder_successor set to the node holding the inorder successor (the smallest value in that subtree)
+      @post unlinks the inorder successor node from the subtree without copying its item
+      @return a pointer to the subtree after inorder successor node has been unlinked
      **/
-template <class T>
-std::shared_ptr<BinaryNode<T>> BinarySearchTree<T>::removeLeftmostNode(std::shared_ptr<BinaryNode<T>> node_ptr, T &inorder_successor)
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::removeLeftmostNode(std::shared_ptr<BinaryNode<T>> node_ptr, std::shared_ptr<BinaryNode<T>> &inorder_successor)
 {
-  if (node_ptr->getLeftChildPtr() == nullptr)
+  std::size_t first_step = path_.size();
+  const std::shared_ptr<BinaryNode<T>> *link = &node_ptr;
+  while ((*link)->getLeftChildPtr() != nullptr)
   {
-    inorder_successor = node_ptr->getItem();
-    return removeNode(node_ptr);
+    path_.push_back(PathStep{link, true});
+    link = &(*link)->getLeftChildPtr();
   }
-  else
-  {
-    node_ptr->setLeftChildPtr(removeLeftmostNode(node_ptr->getLeftChildPtr(), inorder_successor));
-    return node_ptr;
-  } // end if
+  // The leftmost node has at most a right child, which takes its place
+  inorder_successor = ownNode(*link);
+  std::shared_ptr<BinaryNode<T>> right = inorder_successor->getRightChildPtr();
+  inorder_successor->setRightChildPtr(nullptr);
+  return unwindPath(first_step, std::move(right));
 } // end removeLeftmostNode
 
 
@@ -254,8 +1197,8 @@ std::shared_ptr<BinaryNode<T>> BinarySearchTree<T>::removeLeftmostNode(std::shar
       @post removed the node pointed to by parameter retaining the BST property
       @return a pointer to the subtree after node has been removed
      **/
-template <class T>
-std::shared_ptr<BinaryNode<T>> BinarySearchTree<T>::removeNode(std::shared_ptr<BinaryNode<T>> node_ptr)
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::removeNode(std::shared_ptr<BinaryNode<T>> node_ptr)
 {
   // Case 1) Node is a leaf - it is deleted
   if (node_ptr->isLeaf())
@@ -275,52 +1218,195 @@ std::shared_ptr<BinaryNode<T>> BinarySearchTree<T>::removeNode(std::shared_ptr<B
   // Case 3) Node has two children: Find successor node.
   else
   {
-    // Traditional way to remove a value in a node with two children
-    T new_node_value;
-    node_ptr->setRightChildPtr(removeLeftmostNode(node_ptr->getRightChildPtr(), new_node_value));
-    node_ptr->setItem(new_node_value);
-    return node_ptr;
+    // Unlink the successor node and put it where node_ptr was, so no item is copied
+    std::shared_ptr<BinaryNode<T>> successor;
+    std::shared_ptr<BinaryNode<T>> new_right = removeLeftmostNode(node_ptr->getRightChildPtr(), successor);
+    successor->setLeftChildPtr(node_ptr->getLeftChildPtr());
+    successor->setRightChildPtr(new_right);
+    successor->updateCounts();
+    auto unshare = [this](const std::shared_ptr<BinaryNode<T>> &shared_ptr) { return ownNode(shared_ptr); };
+    return BalancePolicy::rebalance(successor, unshare);
   } // end if
 } // end removeNode
 
 
 /** called by remove
       @param subtree_ptr a pointer to the subtree in which to look for the value to be removed
-      @param target the item to be removed
-      @param success a flag to indicate that item was successfully removed
+      @param target the key of the item to be removed
+      @param removed set to the unlinked node holding target; left nullptr if not found
       @return a pointer to the subtree in which target is found
      **/
-template <class T>
-std::shared_ptr<BinaryNode<T>> BinarySearchTree<T>::removeValue(std::shared_ptr<BinaryNode<T>> subtree_ptr, const T target, bool &success)
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class K>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::removeValue(std::shared_ptr<BinaryNode<T>> subtree_ptr, const K &target, std::shared_ptr<BinaryNode<T>> &removed)
 {
-  if (subtree_ptr == nullptr)
+  std::size_t first_step = path_.size();
+  const std::shared_ptr<BinaryNode<T>> *link = &subtree_ptr;
+  while (*link != nullptr)
   {
-    // Not found here
-    success = false;
-    return subtree_ptr;
+    if (keyLess(target, KeyPolicy::key((*link)->getItem())))
+    {
+      path_.push_back(PathStep{link, true}); // Search the left subtree
+      link = &(*link)->getLeftChildPtr();
+    }
+    else if (keyLess(KeyPolicy::key((*link)->getItem()), target))
+    {
+      path_.push_back(PathStep{link, false}); // Search the right subtree
+      link = &(*link)->getRightChildPtr();
+    }
+    else
+      break;
   }
-  if ((subtree_ptr->getItem() == target))
+  if (*link == nullptr)
   {
-    // Item is in the root of some subtree
-    subtree_ptr = removeNode(subtree_ptr);
-    success = true;
+    // Not found
+    path_.resize(first_step);
     return subtree_ptr;
   }
+  // Item is in the root of some subtree
+  removed = *link;
+  std::shared_ptr<BinaryNode<T>> replacement = removeNode(removed);
+  if (removed->getOwner() == owner_)
+  {
+    removed->setLeftChildPtr(nullptr);
+    removed->setRightChildPtr(nullptr);
+    removed->updateCounts();
+  }
   else
+    removed = makeNode(removed->getItem()); // a snapshot still links the node; hand back an unlinked copy
+  return unwindPath(first_step, std::move(replacement));
+} // end removeValue
+
+/** called by lower_bound and upper_bound
+      @param key the key to compare with
+      @param inclusive whether an item whose key equals key qualifies
+      @return an iterator to the first item whose key is greater than key,
+              or equal to it if inclusive **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class K>
+typename BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::const_iterator BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::boundFor(const K &key, bool inclusive) const
+{
+  // Descend once, keeping the whole path; the answer is the last node at
+  // which the search turned left, so the path is cut back to it at the end
+  const_iterator bound;
+  bound.root_ = root_ptr_.get();
+  std::size_t bound_depth = 0;
+  const BinaryNode<T> *node = root_ptr_.get();
+  while (node != nullptr)
   {
-    if (subtree_ptr->getItem() > target)
+    bound.path_.push_back(node);
+    bool qualifies = inclusive ? !keyLess(KeyPolicy::key(node->getItem()), key)
+                               : keyLess(key, KeyPolicy::key(node->getItem()));
+    if (qualifies)
     {
-      // Search the left subtree
-      subtree_ptr->setLeftChildPtr(removeValue(subtree_ptr->getLeftChildPtr(), target, success));
+      bound_depth = bound.path_.size();
+      node = node->getLeftChildPtr().get();
     }
     else
+      node = node->getRightChildPtr().get();
+  }
+  bound.path_.resize(bound_depth);
+  return bound;
+} // end boundFor
+
+/** called by placeNode, insertUnique, removeLeftmostNode and removeValue
+      @param first_step the index in path_ of the first step taken below the subtree root
+      @param subtree_ptr the subtree that replaces the link at the bottom of the path
+      @post links subtree_ptr in and rebalances each node on the path bottom-up,
+            stopping early once a subtree comes back with the same root and
+            height; the steps from first_step on are popped off path_
+      @return a pointer to the root of the subtree the path started at
+     **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::unwindPath(std::size_t first_step, std::shared_ptr<BinaryNode<T>> subtree_ptr)
+{
+  auto unshare = [this](const std::shared_ptr<BinaryNode<T>> &shared_ptr) { return ownNode(shared_ptr); };
+  std::size_t step = path_.size();
+  bool settled = false; // no root or height above can change any more, only sizes
+  while (step > first_step)
+  {
+    step--;
+    const std::shared_ptr<BinaryNode<T>> &link_ptr = *path_[step].link;
+    if (settled)
     {
-      // Search the right subtree
-      subtree_ptr->setRightChildPtr(removeValue(subtree_ptr->getRightChildPtr(), target, success));
+      link_ptr->updateCounts(); // already owned, as the node below it is
+      continue;
     }
-    return subtree_ptr;
+    // A node shared with a snapshot is copied; its parent then gets relinked too
+    std::shared_ptr<BinaryNode<T>> node_ptr = ownNode(link_ptr);
+    if (path_[step].went_left)
+      node_ptr->setLeftChildPtr(std::move(subtree_ptr));
+    else
+      node_ptr->setRightChildPtr(std::move(subtree_ptr));
+    int old_height = node_ptr->getHeight();
+    node_ptr->updateCounts();
+    subtree_ptr = BalancePolicy::rebalance(node_ptr, unshare);
+    settled = subtree_ptr == link_ptr && subtree_ptr->getHeight() == old_height;
   }
-} // end removeValue
+  if (settled)
+    subtree_ptr = *path_[first_step].link;
+  path_.resize(first_step);
+  return subtree_ptr;
+} // end unwindPath
 
 
+/** @param node_ptr a node of this tree, or nullptr
+    @return node_ptr if this tree may change it in place; otherwise a copy
+            of it, owned by this tree, with the same item, links and height **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+std::shared_ptr<BinaryNode<T>> BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::ownNode(const std::shared_ptr<BinaryNode<T>> &node_ptr) const
+{
+  if (node_ptr == nullptr || node_ptr->getOwner() == owner_)
+    return node_ptr;
+  std::shared_ptr<BinaryNode<T>> copy_ptr = makeNode(node_ptr->getItem());
+  copy_ptr->setLeftChildPtr(node_ptr->getLeftChildPtr());
+  copy_ptr->setRightChildPtr(node_ptr->getRightChildPtr());
+  copy_ptr->setHeight(node_ptr->getHeight());
+  copy_ptr->setSize(node_ptr->getSize());
+  return copy_ptr;
+} // end ownNode
 
+/** called by balanceInPlace, and by subclasses that keep pointers to nodes
+    @post every node of the tree may be changed in place; nodes shared with
+          a snapshot have been replaced by copies, in O(n) **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+void BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::ownAllNodes()
+{
+  if (root_ptr_ == nullptr)
+    return;
+  root_ptr_ = ownNode(root_ptr_);
+  std::vector<BinaryNode<T> *> pending(1, root_ptr_.get());
+  while (!pending.empty())
+  {
+    BinaryNode<T> *node = pending.back();
+    pending.pop_back();
+    if (node->getLeftChildPtr() != nullptr)
+    {
+      if (node->getLeftChildPtr()->getOwner() != owner_)
+        node->setLeftChildPtr(ownNode(node->getLeftChildPtr()));
+      pending.push_back(node->getLeftChildPtr().get());
+    }
+    if (node->getRightChildPtr() != nullptr)
+    {
+      if (node->getRightChildPtr()->getOwner() != owner_)
+        node->setRightChildPtr(ownNode(node->getRightChildPtr()));
+      pending.push_back(node->getRightChildPtr().get());
+    }
+  }
+} // end ownAllNodes
+
+/** @return a tag no tree has used yet **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+std::uint64_t BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::newOwner()
+{
+  static std::atomic<std::uint64_t> last_owner(0);
+  return ++last_owner;
+} // end newOwner
+
+/** @return true if key a orders before key b (transparent std::less) **/
+template <class T, class BalancePolicy, class NodeAllocator, class KeyPolicy>
+template <class A, class B>
+bool BinarySearchTree<T, BalancePolicy, NodeAllocator, KeyPolicy>::keyLess(const A &a, const B &b)
+{
+  return std::less<>()(a, b);
+} // end keyLess
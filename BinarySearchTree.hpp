@@ -2,16 +2,108 @@
 #define BINARY_SEARCH_TREE_
 
 #include "BinaryNode.hpp"
+#include "BalancePolicy.hpp"
+#include "KeyPolicy.hpp"
+#include "NodePool.hpp"
+#include "ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
 
-template <class T>
+/** @tparam BalancePolicy decides how subtrees are restructured on the way
+    back up from add and remove (see BalancePolicy.hpp). The default keeps
+    the plain, unbalanced BST; AvlPolicy keeps the height O(log n).
+    @tparam NodeAllocator the allocator passed to std::allocate_shared for
+    every node. NodePoolAllocator<BinaryNode<T>> carves nodes out of slabs
+    (see NodePool.hpp).
+    @tparam KeyPolicy extracts the key items are ordered by (see KeyPolicy.hpp);
+    find, contains and erase accept any type that compares with that key.
+    Trees can share nodes: snapshot() returns a second version of the tree
+    in O(1), and from then on add and remove copy the O(log n) nodes they
+    would change instead of changing them (path copying). A version's nodes
+    stay alive as long as some tree holds them.
+    Every node stores the height and size of its subtree (sizes count
+    ItemWeight, 1 per item unless specialized), brought up to date
+    along the path of each add and remove, so getHeight and getNumberOfNodes
+    are O(1) and select and rank are O(log n) in a balanced tree.
+    Whole-tree walks (countIf and copying) fork at every subtree root with
+    at least kParallelSize nodes, running one half on the library's thread
+    pool (see ThreadPool.hpp). **/
+template <class T, class BalancePolicy = NoBalancePolicy, class NodeAllocator = std::allocator<BinaryNode<T>>,
+          class KeyPolicy = IdentityKey>
 class BinarySearchTree
 {
 public:
+  /** An in-order iterator over the items. It holds the path from the root
+      to its node as raw pointers, so moving it is O(1) amortized and needs
+      no parent links; items are read-only because they are the keys.
+      Any add or remove invalidates every iterator. **/
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T *;
+    using reference = const T &;
+
+    const_iterator();
+    reference operator*() const;
+    pointer operator->() const;
+    const_iterator &operator++();
+    const_iterator operator++(int);
+    /** decrementing end() gives the last item **/
+    const_iterator &operator--();
+    const_iterator operator--(int);
+    bool operator==(const const_iterator &other) const;
+    bool operator!=(const const_iterator &other) const;
+
+  private:
+    friend class BinarySearchTree;
+    const BinaryNode<T> *root_;             // kept so end() can step back
+    std::vector<const BinaryNode<T> *> path_; // root first, current node last; empty at end()
+    void pushLeftSpine(const BinaryNode<T> *node);
+    void pushRightSpine(const BinaryNode<T> *node);
+  };
+  using iterator = const_iterator;
+
+  /** The items between two iterators, for use in a range-based for loop **/
+  class Range
+  {
+  public:
+    Range(const_iterator first, const_iterator last);
+    const_iterator begin() const;
+    const_iterator end() const;
+    bool empty() const;
+
+  private:
+    const_iterator first_;
+    const_iterator last_;
+  };
+
   /*Constructors*/
   BinarySearchTree();                                     //default constructor
   BinarySearchTree(const T &root_item);                   //parameterized constructor
   BinarySearchTree(const BinarySearchTree &another_tree); //copy constructor
+  BinarySearchTree(BinarySearchTree &&another_tree);      //move constructor
+
+  /** @post this tree holds copies of the items of another_tree, in O(n) **/
+  BinarySearchTree &operator=(const BinarySearchTree &another_tree);
+
+  /** @post this tree holds the nodes of another_tree, which is left empty **/
+  BinarySearchTree &operator=(BinarySearchTree &&another_tree);
+
+  /** @return a tree holding the same items, in O(1). The two trees share
+              their nodes; from now on each copies a node (and the path
+              above it) before changing it, so neither sees the other's
+              changes, and only the O(log n) nodes on a changed path are
+              ever duplicated. **/
+  BinarySearchTree snapshot();
 
   /** @return root_ptr_ **/
   std::shared_ptr<BinaryNode<T>> getRoot() const;
@@ -19,21 +111,54 @@ public:
   /** @return true if the BinarySearchTree is emtpy, false otherwise **/
   bool isEmpty() const;
 
-  /** @return the height of the BST structure as the number of nodes on the longest path from root to leaf**/
+  /** @return the height of the BST structure as the number of nodes on the longest path from root to leaf, in O(1)**/
   int getHeight() const;
 
-  /** @return the number of Nodes in the BST structure**/
+  /** @return the number of Nodes in the BST structure, in O(1)**/
   int getNumberOfNodes() const;
 
+  /** @param predicate called with every item, possibly on several threads at once
+      @return the number of items for which predicate returns true **/
+  template <class Predicate>
+  int countIf(Predicate predicate) const;
+
+  /** @param subtree_ptr the root of a subtree of this tree
+      @param predicate called with every item of the subtree, possibly on several threads at once
+      @return the number of items of the subtree for which predicate returns true **/
+  template <class Predicate>
+  int countIf(const std::shared_ptr<BinaryNode<T>> &subtree_ptr, Predicate predicate) const;
+
   /** @param a new entry to be added to the BST
       @post new entry is added to the BST retaining the
               BST property, s.t. at any node, all Items in
               its left subtree are < the item at that node
               and all items in its right subtree are > 
-              Note: > and < would need to be overloaded for self made data types
+              Note: < would need to be overloaded for the key of self made data types
     **/
   void add(const T &new_entry);
 
+  /** @param new_entry an entry to be moved into the BST
+      @post same as add(const T&), without copying new_entry**/
+  void add(T &&new_entry);
+
+  /** @param new_entry an entry to be added if no entry with the same key exists
+      @post new_entry is added in the same single descent that checks for it
+      @return the node holding the entry with new_entry's key, and true if
+              new_entry was added, false if an entry with that key was already there**/
+  std::pair<std::shared_ptr<BinaryNode<T>>, bool> tryInsert(const T &new_entry);
+
+  /** @param new_entry an entry to be moved in if no entry with the same key exists
+      @post same as tryInsert(const T&); new_entry is only moved from if it was added
+      @return same as tryInsert(const T&)**/
+  std::pair<std::shared_ptr<BinaryNode<T>>, bool> tryInsert(T &&new_entry);
+
+  /** @param args the arguments of a T constructor
+      @post the entry is built straight into a new node, which is linked in
+            if no entry with the same key exists and released otherwise
+      @return same as tryInsert(const T&)**/
+  template <class... Args>
+  std::pair<std::shared_ptr<BinaryNode<T>>, bool> emplace(Args &&...args);
+
   /** @param entry to be removed from the BST
       @post entry is removed from the BST and retaining its
               BST property, s.t. at any node, all Nodes in
@@ -41,58 +166,289 @@ public:
               and all items in its right subtree are >**/
   bool remove(const T &entry);
 
+  /** @param key the key of the entry to be removed, of any type that
+            compares with KeyPolicy::key(item)
+      @post same as remove(entry) for the entry with that key
+      @return true if an entry was removed**/
+  template <class K>
+  bool erase(const K &key);
+
+  /** @param key the key of the entry to be removed, of any type that
+            compares with KeyPolicy::key(item)
+      @post same as erase(key)
+      @return the unlinked node that held the entry, nullptr if not found**/
+  template <class K>
+  std::shared_ptr<BinaryNode<T>> extract(const K &key);
+
 
   /** @param entry to be found in the BST
       @return true if entry is found in the BST, false otherwise**/
   bool contains(const T &entry) const;
 
+  /** @param key a key of any type that compares with KeyPolicy::key(item)
+      @return true if an entry with that key is in the BST**/
+  template <class K>
+  bool contains(const K &key) const;
+
+  /** @param key a key of any type that compares with KeyPolicy::key(item)
+      @return a pointer to the node holding the entry with that key, nullptr if not found**/
+  template <class K>
+  std::shared_ptr<BinaryNode<T>> find(const K &key) const;
+
+  /** @return an iterator to the smallest item, end() if the BST is empty **/
+  const_iterator begin() const;
+
+  /** @return the past-the-end iterator **/
+  const_iterator end() const;
+
+  /** @param key a key of any type that compares with KeyPolicy::key(item)
+      @return an iterator to the first item whose key is not less than key,
+              found in one O(log n) descent **/
+  template <class K>
+  const_iterator lower_bound(const K &key) const;
+
+  /** @param key a key of any type that compares with KeyPolicy::key(item)
+      @return an iterator to the first item whose key is greater than key **/
+  template <class K>
+  const_iterator upper_bound(const K &key) const;
+
+  /** @param lo, hi keys of any type that compares with KeyPolicy::key(item)
+      @return the items with lo <= key <= hi, in order, visited in place;
+              costs O(log n + k) for k items **/
+  template <class K>
+  Range range(const K &lo, const K &hi) const;
+
+  /** @param k a position in key order, counted from 0
+      @return an iterator to the item with k smaller items, end() if k is
+              not less than getNumberOfNodes(); found in one descent **/
+  const_iterator select(std::size_t k) const;
+
+  /** @param key a key of any type that compares with KeyPolicy::key(item)
+      @return the number of items whose key is less than key, which is the
+              position of the item with that key if there is one **/
+  template <class K>
+  std::size_t rank(const K &key) const;
+
+  /** @param key a key of any type that compares with KeyPolicy::key(item)
+      @return the entry with that key, nullptr if not found; no reference
+              count is touched on the way down **/
+  template <class K>
+  const T *findItem(const K &key) const;
+
+  /** @param first, last keys of any type that compares with KeyPolicy::key(item)
+      @param out receives, for each key in order, the entry with that key or
+             nullptr, as findItem would return it
+      @post the keys are searched kBatchWidth at a time, one level of every
+            search per round, with the nodes of the next round prefetched;
+            the cache misses of one round overlap instead of queueing
+      @return out past the last result **/
+  template <class ForwardIt, class OutputIt>
+  OutputIt findBatch(ForwardIt first, ForwardIt last, OutputIt out) const;
+
+  /** @param key a key of any type that compares with KeyPolicy::key(item)
+      @return the node holding the entry with that key, nullptr if not found;
+              its item may be replaced through setItem as long as the key
+              stays the same. If the node is shared with a snapshot, it and
+              the path above it are copied first. **/
+  template <class K>
+  std::shared_ptr<BinaryNode<T>> findForUpdate(const K &key);
+
+  /** @param new_entry an entry to take the place of the one with its key
+      @post that entry is replaced in one descent, and the sizes stored on
+            the path above it are brought up to date, so new_entry may have
+            another ItemWeight; nodes on the path shared with a snapshot are
+            copied first. Nothing changes if no entry has that key.
+      @return the node now holding new_entry, nullptr if not found **/
+  std::shared_ptr<BinaryNode<T>> replace(T new_entry);
+
+  /** @param first, last a range of entries sorted by key with no two equal keys
+      @post the BST holds exactly those entries, moved out of the range into
+            a perfectly balanced tree built in O(n)**/
+  template <class ForwardIt>
+  void buildFromSorted(ForwardIt first, ForwardIt last);
+
+  /** @param first, last a range of entries sorted by key with no two equal keys
+      @post entries whose key is not in the BST yet are moved in, and the
+            whole BST is rebuilt perfectly balanced in O(n + m); existing
+            nodes are relinked, not copied
+      @return the number of entries added**/
+  template <class ForwardIt>
+  std::size_t mergeSorted(ForwardIt first, ForwardIt last);
+
+  /** @param on_added called with the node of every entry that was added; the
+             node is new, so its item may be replaced through setItem as
+             long as the key stays the same
+      @post same as mergeSorted(first, last)
+      @return the number of entries added**/
+  template <class ForwardIt, class OnAdded>
+  std::size_t mergeSorted(ForwardIt first, ForwardIt last, OnAdded on_added);
+
+  /** @param put_first, put_last entries sorted by key with no two equal keys
+      @param erase_first, erase_last keys sorted with no two equal, none of
+             them the key of an entry to put
+      @param on_removed called with every entry that leaves the BST, erased
+             or replaced by an entry with the same key
+      @post the entries are moved in, each replacing the one with its key if
+            there is one, the entries with the erased keys are dropped, and
+            the whole BST is rebuilt perfectly balanced in O(n + m); kept
+            nodes are relinked, not copied, unless a snapshot shares them
+      @return the number of entries the BST now holds **/
+  template <class PutIt, class EraseIt, class OnRemoved>
+  std::size_t mergeEdits(PutIt put_first, PutIt put_last, EraseIt erase_first, EraseIt erase_last, OnRemoved on_removed);
+
+  /** @post the BST is rebalanced by relinking its nodes (Day-Stout-Warren),
+            so every level but the last is full; no item is copied, nothing
+            is allocated and only O(log n) stack is used (nodes shared with
+            a snapshot are copied first)**/
+  void balanceInPlace();
+
   /**Display preorder traversal through the BST**/
   void displayPreorder();
 
   /**
    * @param: sets the root pointer to the parameter
+   * @post: the stored heights and sizes under it are recomputed, in O(n)
    */
   void setRoot(std::shared_ptr<BinaryNode<T>> new_root_ptr);
 
+  /** @post the tree is empty; nodes no other tree holds are released**/
+  void clear();
+
+protected:
+  /** @param source the tree to share nodes with
+      @post this tree holds the same items as source, in O(1): both point at
+            the same nodes, and from now on each one copies a node (and the
+            path above it) before changing it, so neither sees the other's changes**/
+  void shareFrom(BinarySearchTree &source);
+
+  /** called by balanceInPlace, and by subclasses that keep pointers to nodes
+      @post every node of the tree may be changed in place; nodes shared with
+            a snapshot have been replaced by copies, in O(n) **/
+  void ownAllNodes();
+
+  /** @param item the item to store
+      @return a new leaf holding item, allocated from node_alloc_ **/
+  std::shared_ptr<BinaryNode<T>> makeNode(const T &item) const;
+
+  /** @param item the item to move into the node
+      @return a new leaf holding item, allocated from node_alloc_ **/
+  std::shared_ptr<BinaryNode<T>> makeNode(T &&item) const;
+
+  /** @param count the number of nodes in the subtree to build
+      @param next_node called count times, returning the nodes in key order
+      @post the nodes are linked into a perfectly balanced subtree with
+            up-to-date heights and sizes; next_node may reuse nodes of the old tree, as
+            a node's links are only overwritten after it has been returned
+      @return a pointer to the root of the built subtree**/
+  template <class NextNode>
+  std::shared_ptr<BinaryNode<T>> buildBalanced(std::size_t count, NextNode &next_node);
+
+  /** Walks a tree in order one node at a time, keeping the path on an
+      explicit stack. A node's right child is read before the node is
+      returned, so callers may relink returned nodes while walking. **/
+  class InorderCursor
+  {
+  public:
+    explicit InorderCursor(const std::shared_ptr<BinaryNode<T>> &root_ptr);
+    /** @return true if every node has been returned **/
+    bool done() const;
+    /** @pre !done()
+        @return the node next() will return **/
+    const std::shared_ptr<BinaryNode<T>> &peek() const;
+    /** @pre !done()
+        @return the next node in key order **/
+    std::shared_ptr<BinaryNode<T>> next();
+
+  private:
+    std::vector<std::shared_ptr<BinaryNode<T>>> stack_;
+    void pushLeftSpine(const std::shared_ptr<BinaryNode<T>> &node_ptr);
+  };
+
 private:
+  /** One step of a walk down from a subtree root: the link to the node
+      passed through and which of its children was taken. Links are not
+      written until the walk unwinds bottom-up, so they stay valid. **/
+  struct PathStep
+  {
+    const std::shared_ptr<BinaryNode<T>> *link;
+    bool went_left;
+  };
+
   std::shared_ptr<BinaryNode<T>> root_ptr_;
+  NodeAllocator node_alloc_;
+  std::uint64_t owner_ = 0; // nodes tagged with this may be changed in place
+  std::vector<PathStep> path_; // reused by every add and remove instead of recursion
+
+  /** called by lower_bound and upper_bound
+      @param key the key to compare with
+      @param inclusive whether an item whose key equals key qualifies
+      @return an iterator to the first item whose key is greater than key,
+              or equal to it if inclusive **/
+  template <class K>
+  const_iterator boundFor(const K &key, bool inclusive) const;
+
+  static constexpr int kParallelSize = 4096; // subtrees with at least this many nodes are split across threads
+  static constexpr std::size_t kBatchWidth = 16; // searches findBatch runs side by side
 
   /** called by copy constructor
       @param old_tee_root_ptr a pointer to the root of the tree to be copied
-      @post recursively copies every node in the tree pointed to by the parameter pointer
+      @post copies every node in the tree pointed to by the parameter pointer;
+            large subtrees are copied in parallel, each task allocating from
+            its own thread's cache in the node pool
+      @return a pointer to the root of the copied subtree
+     **/
+  std::shared_ptr<BinaryNode<T>> copyTree(const std::shared_ptr<BinaryNode<T>> &old_tee_root_ptr) const;
+
+  /** called by copyTree
+      @post copies every node of the subtree on this thread, using an explicit stack
       @return a pointer to the root of the copied subtree
      **/
-  std::shared_ptr<BinaryNode<T>> copyTree(const std::shared_ptr<BinaryNode<T>> old_tee_root_ptr) const;
+  std::shared_ptr<BinaryNode<T>> copySubtree(const std::shared_ptr<BinaryNode<T>> &old_subtree_ptr) const;
 
+  /** @return true if the subtree is worth splitting across the thread pool **/
+  static bool shouldFork(const std::shared_ptr<BinaryNode<T>> &subtree_ptr);
 
-  /** called by getHeight
-     @param subtree_ptr a pointer to the root of the current subtree
-     @return the height of the BST structure
-     as the number of nodes on the longest path
-     from root to leaf**/
-  int getHeightHelper(std::shared_ptr<BinaryNode<T>> subtree_ptr) const;
+  /** called by countIf
+      @param serial returns the value of a subtree, walking it on this thread
+      @param combine returns the value of a subtree from its root and the
+             values of its left and right subtrees
+      @return the value of the subtree; while shouldFork, the left half is
+              forked onto the thread pool and the right half done here **/
+  template <class Result, class Serial, class Combine>
+  static Result forkJoin(const std::shared_ptr<BinaryNode<T>> &subtree_ptr, const Serial &serial, const Combine &combine);
 
-  /** called by getNumberOfNodes
-     @param subtree_ptr a pointer to the root of the current subtree
-     @return the number of nodes in the tree**/
-  int getNumberOfNodesHelper(std::shared_ptr<BinaryNode<T>> subtree_ptr) const;
 
   /** called by add(new_entry)
       @param subtree_ptr a pointer to the subtree in which to place the new node
       @param new_node_ptr a pointer to the new node to be added to the tree
-      @post recursively places the new node as a leaf retaining the BST property
+      @post places the new node as a leaf retaining the BST property,
+            rebalancing every subtree on the path back up
       @return a pointer to the root of the subtree in which node was placed
      **/
   std::shared_ptr<BinaryNode<T>> placeNode(std::shared_ptr<BinaryNode<T>> subtree_ptr, std::shared_ptr<BinaryNode<T>> new_node_ptr);
 
+  /** called by tryInsert and emplace
+      @param subtree_ptr a pointer to the subtree in which to place the new entry
+      @param key the key of the new entry
+      @param make_node called once, only when key is absent, to get the node to link in
+      @param result set to the node holding key and whether it was added
+      @post places the new node as a leaf retaining the BST property,
+            rebalancing every subtree on the path back up
+      @return a pointer to the root of the subtree
+     **/
+  template <class K, class MakeNode>
+  std::shared_ptr<BinaryNode<T>> insertUnique(std::shared_ptr<BinaryNode<T>> subtree_ptr, const K &key, MakeNode &make_node,
+                                              std::pair<std::shared_ptr<BinaryNode<T>>, bool> &result);
+
 
   /** called by remove
       @param subtree_ptr a pointer to the subtree in which to look for the value to be removed
-      @param target the item to be removed
-      @param success a flag to indicate that item was successfully removed
+      @param target the key of the item to be removed
+      @param removed set to the unlinked node holding target; left nullptr if not found
       @return a pointer to the subtree in which target is found
      **/
-  std::shared_ptr<BinaryNode<T>> removeValue(std::shared_ptr<BinaryNode<T>> subtree_ptr, const T target, bool &success);
+  template <class K>
+  std::shared_ptr<BinaryNode<T>> removeValue(std::shared_ptr<BinaryNode<T>> subtree_ptr, const K &target, std::shared_ptr<BinaryNode<T>> &removed);
 
   /** called by removeValue
       @param node_ptr a pointer to the node to be removed
@@ -102,23 +458,58 @@ private:
   std::shared_ptr<BinaryNode<T>> removeNode(std::shared_ptr<BinaryNode<T>> node_ptr);
 
 
+  /** @param node_ptr a node of this tree, or nullptr
+      @return node_ptr if this tree may change it in place; otherwise a copy
+              of it, owned by this tree, with the same item, links, height and size **/
+  std::shared_ptr<BinaryNode<T>> ownNode(const std::shared_ptr<BinaryNode<T>> &node_ptr) const;
+
+  /** @return a tag no tree has used yet **/
+  static std::uint64_t newOwner();
+
+  /** called by placeNode, insertUnique, removeLeftmostNode and removeValue
+      @param first_step the index in path_ of the first step taken below the subtree root
+      @param subtree_ptr the subtree that replaces the link at the bottom of the path
+      @post links subtree_ptr in and rebalances each node on the path bottom-up;
+            once a subtree comes back with the same root and height, the
+            nodes above only get their sizes updated. The steps from
+            first_step on are popped off path_
+      @return a pointer to the root of the subtree the path started at
+     **/
+  std::shared_ptr<BinaryNode<T>> unwindPath(std::size_t first_step, std::shared_ptr<BinaryNode<T>> subtree_ptr);
+
   /** called by removeNode
-      @param node_ptr a pointer to the node to be removed
-      @param inorder_successor a reference to the  inorder successor (the smallest value in the left subtree) of the node to be deleted
-      @post removes the node containing the inorder successor
-      @return a pointer to the subtree after inorder successor node has been deleted
+      @param node_ptr a pointer to the root of the right subtree of the node to be removed
+      @param inorder_successor set to the node holding the inorder successor (the smallest value in that subtree)
+      @post unlinks the inorder successor node from the subtree without copying its item
+      @return a pointer to the subtree after inorder successor node has been unlinked
      **/
-  std::shared_ptr<BinaryNode<T>> removeLeftmostNode(std::shared_ptr<BinaryNode<T>> node_ptr, T &inorder_successor);
+  std::shared_ptr<BinaryNode<T>> removeLeftmostNode(std::shared_ptr<BinaryNode<T>> node_ptr, std::shared_ptr<BinaryNode<T>> &inorder_successor);
 
   /** called by contains
       @param subtree_ptr a pointer to the subtree to be searched
-      @param target a reference to the item to be found
+      @param target a reference to the key to be found
       @return a pointer to the node containing the target, nullptr if not found
      **/
-  std::shared_ptr<BinaryNode<T>> findNode(std::shared_ptr<BinaryNode<T>> subtree_ptr, const T &target) const;
+  template <class K>
+  std::shared_ptr<BinaryNode<T>> findNode(const std::shared_ptr<BinaryNode<T>> &subtree_ptr, const K &target) const;
+
+  /** @return true if key a orders before key b (transparent std::less) **/
+  template <class A, class B>
+  static bool keyLess(const A &a, const B &b);
+
+  /** called by balanceInPlace
+      @param parent the vine node whose right link starts the run, nullptr for the root
+      @param count the number of left rotations to do down the right vine
+      @post every second node of the run is rotated up one level**/
+  void compressVine(BinaryNode<T> *parent, std::size_t count);
+
+  /** called by balanceInPlace and setRoot
+      @param subtree_ptr a pointer to the root of a subtree
+      @post the height and size stored in every node of the subtree are correct**/
+  void restoreCounts(const std::shared_ptr<BinaryNode<T>> &subtree_ptr);
 
   //display helpers
-  void preorderHelper(std::shared_ptr<BinaryNode<T>> node);
+  void preorderHelper(const std::shared_ptr<BinaryNode<T>> &node);
 
 
 };
@@ -0,0 +1,207 @@
+/** @file ConcurrentRecipeBook.cpp */
+
+#include "ConcurrentRecipeBook.hpp"
+#include "RecipeCsv.hpp"
+
+ConcurrentRecipeBook::Reader::Reader(const ConcurrentRecipeBook &book)
+    : source_(&book), book_(book.snapshot()), version_(0)
+{
+} // end constructor
+
+bool ConcurrentRecipeBook::Reader::refresh()
+{
+  // current_ is stored before version_ is bumped, so the book loaded is at
+  // least as new as latest
+  std::uint64_t latest = source_->version_.load(std::memory_order_acquire);
+  if (latest == version_)
+    return false;
+  book_ = source_->snapshot();
+  version_ = latest;
+  return true;
+} // end refresh
+
+const Recipe *ConcurrentRecipeBook::Reader::findRecipe(std::string_view name)
+{
+  refresh();
+  return book_->findItem(name);
+} // end findRecipe
+
+std::vector<const Recipe *> ConcurrentRecipeBook::Reader::findMany(const std::vector<std::string_view> &names)
+{
+  refresh();
+  return book_->findMany(names);
+} // end findMany
+
+int ConcurrentRecipeBook::Reader::calculateMasteryPoints(const std::string &name)
+{
+  refresh();
+  return book_->calculateMasteryPoints(name);
+} // end calculateMasteryPoints
+
+const RecipeBook &ConcurrentRecipeBook::Reader::getBook()
+{
+  refresh();
+  return *book_;
+} // end getBook
+
+std::uint64_t ConcurrentRecipeBook::Reader::getVersion() const
+{
+  return version_;
+} // end getVersion
+
+ConcurrentRecipeBook::ConcurrentRecipeBook()
+    : current_(std::make_shared<const RecipeBook>()), version_(0)
+{
+} // end constructor
+
+std::shared_ptr<const RecipeBook> ConcurrentRecipeBook::snapshot() const
+{
+  return std::atomic_load(&current_);
+} // end snapshot
+
+std::uint64_t ConcurrentRecipeBook::getVersion() const
+{
+  return version_.load(std::memory_order_acquire);
+} // end getVersion
+
+std::shared_ptr<const BinaryNode<Recipe>> ConcurrentRecipeBook::findRecipe(const std::string &name) const
+{
+  return snapshot()->findRecipe(name);
+} // end findRecipe
+
+int ConcurrentRecipeBook::calculateMasteryPoints(const std::string &name) const
+{
+  return snapshot()->calculateMasteryPoints(name);
+} // end calculateMasteryPoints
+
+bool ConcurrentRecipeBook::openJournal(const std::string &path, std::string &error, RecipeJournal::Options options)
+{
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  if (journal_ != nullptr)
+  {
+    error = path + ": a journal is already open";
+    return false;
+  }
+  std::unique_ptr<RecipeJournal> journal(new RecipeJournal());
+  RecipeBook loaded;
+  loaded.useNameIndex(working_.usesNameIndex());
+  if (!journal->open(path, loaded, error, options))
+    return false;
+  working_ = std::move(loaded);
+  journal_ = std::move(journal);
+  publish();
+  return true;
+} // end openJournal
+
+std::string ConcurrentRecipeBook::getJournalError() const
+{
+  return journal_ == nullptr ? std::string() : journal_->getError();
+} // end getJournalError
+
+bool ConcurrentRecipeBook::addRecipe(const Recipe &recipe)
+{
+  std::uint64_t logged = 0;
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (!working_.addRecipe(recipe))
+      return false;
+    if (journal_ != nullptr)
+      logged = journal_->logAdd(recipe);
+    publish();
+  }
+  commit(logged);
+  return true;
+} // end addRecipe
+
+bool ConcurrentRecipeBook::removeRecipe(const std::string &name)
+{
+  std::uint64_t logged = 0;
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (!working_.removeRecipe(name))
+      return false;
+    if (journal_ != nullptr)
+      logged = journal_->logRemove(name);
+    publish();
+  }
+  commit(logged);
+  return true;
+} // end removeRecipe
+
+bool ConcurrentRecipeBook::setMastered(const std::string &name, bool mastered)
+{
+  std::uint64_t logged = 0;
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (!working_.setMastered(name, mastered))
+      return false;
+    if (journal_ != nullptr)
+      logged = journal_->logSetMastered(name, mastered);
+    publish();
+  }
+  commit(logged);
+  return true;
+} // end setMastered
+
+std::size_t ConcurrentRecipeBook::bulkLoad(std::vector<Recipe> recipes)
+{
+  std::uint64_t logged = 0;
+  std::size_t added = 0;
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (journal_ != nullptr)
+    {
+      // Replaying the batch as single adds, in the same order, gives the same book
+      for (const Recipe &recipe : recipes)
+        logged = journal_->logAdd(recipe);
+    }
+    added = working_.bulkLoad(std::move(recipes));
+    if (added > 0)
+      publish();
+  }
+  commit(logged);
+  return added;
+} // end bulkLoad
+
+bool ConcurrentRecipeBook::loadCsv(const std::string &filename, std::string &error)
+{
+  std::vector<Recipe> recipes;
+  if (!readRecipeCsvSorted(filename, recipes, error)) // parsed before the write lock is taken
+    return false;
+  bulkLoad(std::move(recipes));
+  return true;
+} // end loadCsv
+
+void ConcurrentRecipeBook::clear()
+{
+  std::uint64_t logged = 0;
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    working_.clear();
+    if (journal_ != nullptr)
+      logged = journal_->logClear();
+    publish();
+  }
+  commit(logged);
+} // end clear
+
+void ConcurrentRecipeBook::publish()
+{
+  std::shared_ptr<const RecipeBook> published = std::make_shared<const RecipeBook>(working_.snapshot());
+  std::atomic_store(&current_, std::move(published));
+  version_.fetch_add(1, std::memory_order_release);
+  compactIfNeeded();
+} // end publish
+
+void ConcurrentRecipeBook::compactIfNeeded()
+{
+  // Under the write lock, so the snapshot holds exactly the changes logged so far
+  if (journal_ != nullptr && journal_->needsCompaction())
+    journal_->startCompaction(working_.snapshot());
+} // end compactIfNeeded
+
+void ConcurrentRecipeBook::commit(std::uint64_t sequence)
+{
+  if (sequence != 0) // journal_ is never reset once set
+    journal_->commit(sequence);
+} // end commit
@@ -0,0 +1,137 @@
+/** A RecipeBook that many threads can read while one thread at a time writes.
+ Writers change a private working book under a mutex, then publish it: the
+ published book is a snapshot of the working book (see RecipeBook::snapshot)
+ sharing all of its nodes, so publishing is O(1) no matter how many
+ Recipes there are, and the next write copies only the nodes on the path it
+ changes. Readers never lock; they atomically load the latest published
+ book, which never changes once published, and may keep it as long as they
+ like. A Reader caches that book and only reloads it when the version
+ counter says a newer one was published.
+ With a journal open (see openJournal), every write is also appended to a
+ write-ahead log under the write lock, and the writer then waits, without
+ the lock, until the log is on disk; writers that arrive meanwhile share
+ the next sync (see RecipeJournal.hpp).
+ @file ConcurrentRecipeBook.hpp */
+
+#ifndef CONCURRENT_RECIPE_BOOK_
+#define CONCURRENT_RECIPE_BOOK_
+
+#include "RecipeBook.hpp"
+#include "RecipeJournal.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ConcurrentRecipeBook
+{
+public:
+  /** Lock-free lookups for one thread; each thread needs its own Reader. **/
+  class Reader
+  {
+  public:
+    /** @param book the book to read; it must outlive the Reader **/
+    explicit Reader(const ConcurrentRecipeBook &book);
+
+    /** @post the Reader holds the latest published book
+        @return true if a newer book was loaded **/
+    bool refresh();
+
+    /** @param name the name to look up
+        @return the Recipe with that name in the latest published book,
+                nullptr if not found; valid until the next call on this Reader **/
+    const Recipe *findRecipe(std::string_view name);
+
+    /** @param names the names to look up
+        @return RecipeBook::findMany(names) on the latest published book;
+                valid until the next call on this Reader **/
+    std::vector<const Recipe *> findMany(const std::vector<std::string_view> &names);
+
+    /** @param name the name of a Recipe
+        @return RecipeBook::calculateMasteryPoints(name) on the latest published book **/
+    int calculateMasteryPoints(const std::string &name);
+
+    /** @return the latest published book; valid until the next call on this Reader **/
+    const RecipeBook &getBook();
+
+    /** @return the version of the book the Reader holds **/
+    std::uint64_t getVersion() const;
+
+  private:
+    const ConcurrentRecipeBook *source_;
+    std::shared_ptr<const RecipeBook> book_;
+    std::uint64_t version_;
+  };
+
+  ConcurrentRecipeBook();
+
+  ConcurrentRecipeBook(const ConcurrentRecipeBook &) = delete;
+  ConcurrentRecipeBook &operator=(const ConcurrentRecipeBook &) = delete;
+
+  /** @return the latest published book; it never changes, so any thread may
+              read it for as long as it holds it **/
+  std::shared_ptr<const RecipeBook> snapshot() const;
+
+  /** @return how many books have been published; grows with every write **/
+  std::uint64_t getVersion() const;
+
+  /** @param name the name to look up
+      @return the node holding the Recipe in the latest published book,
+              nullptr if not found **/
+  std::shared_ptr<const BinaryNode<Recipe>> findRecipe(const std::string &name) const;
+
+  /** @param name the name of a Recipe
+      @return RecipeBook::calculateMasteryPoints(name) on the latest published book **/
+  int calculateMasteryPoints(const std::string &name) const;
+
+  /** @param path the journal's snapshot file (see RecipeJournal.hpp)
+      @param error set to a message if the journal cannot be opened
+      @param options when the journal syncs and compacts
+      @post the book holds the saved snapshot with the logged changes
+            replayed, replacing what it held before; from now on every
+            write is logged, and the log is compacted in the background
+            once it grows past options.compact_bytes
+      @return true if the journal is open **/
+  bool openJournal(const std::string &path, std::string &error, RecipeJournal::Options options = RecipeJournal::Options());
+
+  /** @return the first error of the journal, empty if there was none or no
+              journal is open; a write that could not be logged stays in
+              the book but may be lost on restart **/
+  std::string getJournalError() const;
+
+  /** Writers: each runs under the write lock and publishes a new book when
+      the Recipes changed. See the RecipeBook methods of the same name.
+      With a journal, each returns once its change is logged. **/
+  bool addRecipe(const Recipe &recipe);
+  bool removeRecipe(const std::string &name);
+  bool setMastered(const std::string &name, bool mastered);
+  std::size_t bulkLoad(std::vector<Recipe> recipes);
+  bool loadCsv(const std::string &filename, std::string &error);
+  void clear();
+
+private:
+  std::mutex write_mutex_;                  // held by the one thread writing
+  RecipeBook working_;                      // changed by writers only
+  std::shared_ptr<const RecipeBook> current_; // accessed with std::atomic_load / atomic_store
+  std::atomic<std::uint64_t> version_;      // bumped after current_ is replaced
+  std::unique_ptr<RecipeJournal> journal_;  // set once by openJournal; nullptr if none
+
+  /** called by the writers with write_mutex_ held
+      @post current_ shares the nodes of working_, and version_ is bumped **/
+  void publish();
+
+  /** called by the writers with write_mutex_ held, after logging a change
+      @post a compaction is started if the log has grown too long **/
+  void compactIfNeeded();
+
+  /** called by the writers once write_mutex_ is released
+      @param sequence the journal record of the write, 0 if none
+      @post the record is on disk, as the journal's options ask **/
+  void commit(std::uint64_t sequence);
+};
+
+#endif
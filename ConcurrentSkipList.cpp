@@ -0,0 +1,241 @@
+/** @file ConcurrentSkipList.cpp */
+
+#include "ConcurrentSkipList.hpp"
+#include <cstdint>
+#include <functional>
+#include <new>
+
+template <class T, class KeyPolicy>
+template <class U>
+ConcurrentSkipList<T, KeyPolicy>::Node::Node(U &&entry, int node_height, std::atomic<Node *> *links)
+    : next(links), height(node_height), item(std::forward<U>(entry))
+{
+} // end Node constructor
+
+template <class T, class KeyPolicy>
+ConcurrentSkipList<T, KeyPolicy>::ConcurrentSkipList() : top_level_(1)
+{
+  for (int level = 0; level < kMaxLevel; level++)
+    head_[level].store(nullptr, std::memory_order_relaxed);
+} // end constructor
+
+template <class T, class KeyPolicy>
+ConcurrentSkipList<T, KeyPolicy>::~ConcurrentSkipList()
+{
+  clear();
+} // end destructor
+
+template <class T, class KeyPolicy>
+std::pair<const T *, bool> ConcurrentSkipList<T, KeyPolicy>::tryInsert(const T &new_entry)
+{
+  return insertEntry(new_entry);
+} // end tryInsert
+
+template <class T, class KeyPolicy>
+std::pair<const T *, bool> ConcurrentSkipList<T, KeyPolicy>::tryInsert(T &&new_entry)
+{
+  return insertEntry(std::move(new_entry));
+} // end tryInsert
+
+template <class T, class KeyPolicy>
+template <class K>
+const T *ConcurrentSkipList<T, KeyPolicy>::find(const K &key) const
+{
+  const std::atomic<Node *> *links = head_;
+  for (int level = top_level_.load(std::memory_order_acquire) - 1; level >= 0; level--)
+  {
+    Node *node = links[level].load(std::memory_order_acquire);
+    while (node != nullptr && keyLess(KeyPolicy::key(node->item), key))
+    {
+      links = node->next;
+      node = links[level].load(std::memory_order_acquire);
+    }
+    if (level == 0 && node != nullptr && !keyLess(key, KeyPolicy::key(node->item)))
+      return &node->item;
+  }
+  return nullptr;
+} // end find
+
+template <class T, class KeyPolicy>
+template <class K>
+bool ConcurrentSkipList<T, KeyPolicy>::contains(const K &key) const
+{
+  return find(key) != nullptr;
+} // end contains
+
+template <class T, class KeyPolicy>
+bool ConcurrentSkipList<T, KeyPolicy>::isEmpty() const
+{
+  return head_[0].load(std::memory_order_acquire) == nullptr;
+} // end isEmpty
+
+template <class T, class KeyPolicy>
+int ConcurrentSkipList<T, KeyPolicy>::getNumberOfNodes() const
+{
+  int count = 0;
+  for (Node *node = head_[0].load(std::memory_order_acquire); node != nullptr; node = node->next[0].load(std::memory_order_acquire))
+    count++;
+  return count;
+} // end getNumberOfNodes
+
+template <class T, class KeyPolicy>
+template <class Visit>
+void ConcurrentSkipList<T, KeyPolicy>::forEach(Visit visit) const
+{
+  for (Node *node = head_[0].load(std::memory_order_acquire); node != nullptr; node = node->next[0].load(std::memory_order_acquire))
+    visit(static_cast<const T &>(node->item));
+} // end forEach
+
+template <class T, class KeyPolicy>
+std::vector<T> ConcurrentSkipList<T, KeyPolicy>::takeAll()
+{
+  std::vector<T> entries;
+  for (Node *node = head_[0].load(std::memory_order_relaxed); node != nullptr; node = node->next[0].load(std::memory_order_relaxed))
+    entries.push_back(std::move(node->item));
+  clear();
+  return entries;
+} // end takeAll
+
+template <class T, class KeyPolicy>
+void ConcurrentSkipList<T, KeyPolicy>::clear()
+{
+  Node *node = head_[0].load(std::memory_order_relaxed);
+  while (node != nullptr)
+  {
+    Node *next = node->next[0].load(std::memory_order_relaxed);
+    destroyNode(node);
+    node = next;
+  }
+  for (int level = 0; level < kMaxLevel; level++)
+    head_[level].store(nullptr, std::memory_order_relaxed);
+  top_level_.store(1, std::memory_order_relaxed);
+} // end clear
+
+template <class T, class KeyPolicy>
+template <class U>
+typename ConcurrentSkipList<T, KeyPolicy>::Node *ConcurrentSkipList<T, KeyPolicy>::makeNode(U &&entry, int height)
+{
+  // sizeof(Node) is a multiple of its alignment, so the links that follow are aligned
+  void *block = ::operator new(sizeof(Node) + height * sizeof(std::atomic<Node *>));
+  std::atomic<Node *> *links = reinterpret_cast<std::atomic<Node *> *>(static_cast<unsigned char *>(block) + sizeof(Node));
+  for (int level = 0; level < height; level++)
+    new (links + level) std::atomic<Node *>(nullptr);
+  try
+  {
+    return new (block) Node(std::forward<U>(entry), height, links);
+  }
+  catch (...)
+  {
+    ::operator delete(block);
+    throw;
+  }
+} // end makeNode
+
+template <class T, class KeyPolicy>
+void ConcurrentSkipList<T, KeyPolicy>::destroyNode(Node *node)
+{
+  node->~Node(); // the links are trivially destructible
+  ::operator delete(static_cast<void *>(node));
+} // end destroyNode
+
+template <class T, class KeyPolicy>
+int ConcurrentSkipList<T, KeyPolicy>::randomHeight()
+{
+  // xorshift per thread, so producers never share generator state
+  thread_local std::uint64_t state = 0x9E3779B97F4A7C15ull ^ std::hash<const void *>()(&state);
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  int height = 1;
+  std::uint64_t bits = state;
+  while (height < kMaxLevel && (bits & 3) == 0)
+  {
+    height++;
+    bits >>= 2;
+  }
+  return height;
+} // end randomHeight
+
+template <class T, class KeyPolicy>
+void ConcurrentSkipList<T, KeyPolicy>::giveBack(const T &, T &)
+{
+} // end giveBack
+
+template <class T, class KeyPolicy>
+void ConcurrentSkipList<T, KeyPolicy>::giveBack(T &entry, T &item)
+{
+  entry = std::move(item);
+} // end giveBack
+
+template <class T, class KeyPolicy>
+template <class A, class B>
+bool ConcurrentSkipList<T, KeyPolicy>::keyLess(const A &a, const B &b)
+{
+  return std::less<>()(a, b);
+} // end keyLess
+
+template <class T, class KeyPolicy>
+template <class K>
+typename ConcurrentSkipList<T, KeyPolicy>::Node *ConcurrentSkipList<T, KeyPolicy>::findLinks(const K &key, std::atomic<Node *> **preds, Node **succs) const
+{
+  std::atomic<Node *> *links = const_cast<std::atomic<Node *> *>(head_);
+  for (int level = kMaxLevel - 1; level >= 0; level--)
+  {
+    Node *node = links[level].load(std::memory_order_acquire);
+    while (node != nullptr && keyLess(KeyPolicy::key(node->item), key))
+    {
+      links = node->next;
+      node = links[level].load(std::memory_order_acquire);
+    }
+    preds[level] = &links[level];
+    succs[level] = node;
+  }
+  if (succs[0] != nullptr && !keyLess(key, KeyPolicy::key(succs[0]->item)))
+    return succs[0];
+  return nullptr;
+} // end findLinks
+
+template <class T, class KeyPolicy>
+template <class U>
+std::pair<const T *, bool> ConcurrentSkipList<T, KeyPolicy>::insertEntry(U &&entry)
+{
+  std::atomic<Node *> *preds[kMaxLevel];
+  Node *succs[kMaxLevel];
+  Node *node = nullptr;
+  while (true)
+  {
+    // Once entry is moved into the node, only the node's copy of the key is valid
+    Node *found = node == nullptr ? findLinks(KeyPolicy::key(entry), preds, succs) : findLinks(KeyPolicy::key(node->item), preds, succs);
+    if (found != nullptr)
+    {
+      if (node != nullptr)
+      {
+        giveBack(entry, node->item); // another thread added the key first
+        destroyNode(node);
+      }
+      return std::make_pair(static_cast<const T *>(&found->item), false);
+    }
+    if (node == nullptr)
+      node = makeNode(std::forward<U>(entry), randomHeight());
+    node->next[0].store(succs[0], std::memory_order_relaxed);
+    // Publishes the node; fails if another node was linked after preds[0] meanwhile
+    if (preds[0]->compare_exchange_strong(succs[0], node, std::memory_order_release, std::memory_order_relaxed))
+      break;
+  }
+  const T &key_item = node->item; // entry may have been moved into the node
+  for (int level = 1; level < node->height; level++)
+  {
+    while (true)
+    {
+      node->next[level].store(succs[level], std::memory_order_relaxed);
+      if (preds[level]->compare_exchange_strong(succs[level], node, std::memory_order_release, std::memory_order_relaxed))
+        break;
+      findLinks(KeyPolicy::key(key_item), preds, succs); // a neighbour was linked first; look again
+    }
+  }
+  int top = top_level_.load(std::memory_order_relaxed);
+  while (top < node->height && !top_level_.compare_exchange_weak(top, node->height, std::memory_order_release, std::memory_order_relaxed))
+  {
+  }
+  return std::make_pair(static_cast<const T *>(&node->item), true);
+} // end insertEntry
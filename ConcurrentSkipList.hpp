@@ -0,0 +1,129 @@
+/** A lock-free ordered set for many threads inserting at once.
+ Items live in a skip list: every node is linked into level 0, which holds
+ all items in key order, and into a random number of the levels above it,
+ each holding about a quarter of the level below, so a search skips ahead
+ in O(log n) expected steps. A node is published by one compare-and-swap
+ on the level 0 link of its predecessor; the CAS fails if another thread
+ linked a node there first, and the insert then searches again from the
+ top, so two threads can never add the same key. The upper levels are
+ linked afterwards the same way and only speed up searches.
+ Nodes are never removed while threads share the list, so a pointer read
+ from a link stays valid without hazard pointers or epochs; clear and
+ takeAll are for one thread only, once the producers are done.
+ Keys are unique: tryInsert does nothing when an item with the same key
+ exists, like BinarySearchTree::tryInsert.
+ Scope: this is a staging set for producers, not a concurrent drop-in for
+ BinarySearchTree. It offers only the insert and lookup half of that API;
+ there is no remove (unlinking would need safe memory reclamation), no
+ getHeight and no iterators. Drain it into a tree with takeAll (or
+ RecipeBook::bulkLoad) to get the rest.
+ @tparam KeyPolicy extracts the key items are ordered by (see KeyPolicy.hpp).
+ @file ConcurrentSkipList.hpp */
+
+#ifndef CONCURRENT_SKIP_LIST_
+#define CONCURRENT_SKIP_LIST_
+
+#include "KeyPolicy.hpp"
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+template <class T, class KeyPolicy = IdentityKey>
+class ConcurrentSkipList
+{
+public:
+  static constexpr int kMaxLevel = 16; // enough for about 4^16 items
+
+  ConcurrentSkipList();
+  ~ConcurrentSkipList();
+
+  ConcurrentSkipList(const ConcurrentSkipList &) = delete;
+  ConcurrentSkipList &operator=(const ConcurrentSkipList &) = delete;
+
+  /** Safe to call from any number of threads at once. **/
+
+  /** @param new_entry an entry to be added if no entry with the same key exists
+      @return the entry with new_entry's key, and true if new_entry was added **/
+  std::pair<const T *, bool> tryInsert(const T &new_entry);
+
+  /** @param new_entry an entry to be moved in if no entry with the same key exists
+      @return same as tryInsert(const T&); new_entry is only moved from if it was added **/
+  std::pair<const T *, bool> tryInsert(T &&new_entry);
+
+  /** @param key a key of any type that compares with KeyPolicy::key(item)
+      @return the entry with that key, nullptr if not found **/
+  template <class K>
+  const T *find(const K &key) const;
+
+  /** @param key a key of any type that compares with KeyPolicy::key(item)
+      @return true if an entry with that key is in the list **/
+  template <class K>
+  bool contains(const K &key) const;
+
+  /** @return true if the list is empty **/
+  bool isEmpty() const;
+
+  /** @return the number of items, counted along level 0 in O(n) **/
+  int getNumberOfNodes() const;
+
+  /** @param visit called with every entry, in key order; entries inserted
+                  meanwhile may or may not be visited **/
+  template <class Visit>
+  void forEach(Visit visit) const;
+
+  /** Only while no other thread uses the list. **/
+
+  /** @return every entry, moved out in key order; the list is left empty **/
+  std::vector<T> takeAll();
+
+  /** @post the list is empty **/
+  void clear();
+
+private:
+  struct Node
+  {
+    std::atomic<Node *> *next; // next[level] for level < height, stored right after the node
+    int height;
+    T item;
+    template <class U>
+    Node(U &&entry, int node_height, std::atomic<Node *> *links);
+  };
+
+  std::atomic<Node *> head_[kMaxLevel]; // first node of each level
+  std::atomic<int> top_level_;          // levels that may be non-empty
+
+  /** @return a node holding entry, allocated together with its height links **/
+  template <class U>
+  static Node *makeNode(U &&entry, int height);
+
+  /** @post node and its links are freed **/
+  static void destroyNode(Node *node);
+
+  /** @return a height of at least 1, each further level with probability 1/4 **/
+  static int randomHeight();
+
+  /** called by insertEntry when it loses a race after moving entry into a node
+      @post an entry passed as T&& holds its value again; a const one was copied **/
+  static void giveBack(const T &entry, T &item);
+  static void giveBack(T &entry, T &item);
+
+  /** @return true if key a orders before key b (transparent std::less) **/
+  template <class A, class B>
+  static bool keyLess(const A &a, const B &b);
+
+  /** called by tryInsert
+      @param preds set to the link to change at each level: the next
+             pointer of the last node before key, or head_
+      @param succs set to the first node at or after key at each level
+      @return the node with key, nullptr if not found **/
+  template <class K>
+  Node *findLinks(const K &key, std::atomic<Node *> **preds, Node **succs) const;
+
+  /** called by tryInsert(const T&) and tryInsert(T&&) **/
+  template <class U>
+  std::pair<const T *, bool> insertEntry(U &&entry);
+};
+
+#include "ConcurrentSkipList.cpp"
+#endif
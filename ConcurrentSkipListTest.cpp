@@ -0,0 +1,115 @@
+/** Multi-producer test of ConcurrentSkipList.
+ Several threads insert overlapping sets of keys at once, half of them
+ through tryInsert(const T&) and half through tryInsert(T&&). Afterwards
+ every key must be in the list exactly once, in order, and exactly one
+ insert of each key must have reported adding it. Build and run with
+ "make check"; build it with -fsanitize=thread to check for races too.
+ @file ConcurrentSkipListTest.cpp */
+
+#include "ConcurrentSkipList.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+const int kThreads = 8;
+const int kKeys = 20000;
+const int kKeysPerThread = 12000; // so every key is tried by several threads
+const int kRounds = 20;
+
+/** @return the name of key i, too long for the small string buffer so a
+            moved-from copy is empty **/
+std::string keyName(int i)
+{
+  std::string digits = std::to_string(i);
+  return "staged recipe " + std::string(6 - digits.size(), '0') + digits;
+}
+
+/** @return true if one round passed **/
+bool runRound(int round)
+{
+  ConcurrentSkipList<std::string> list;
+  std::vector<std::atomic<int>> added(kKeys);
+  for (std::atomic<int> &count : added)
+    count.store(0);
+
+  std::atomic<bool> go(false);
+  std::vector<std::thread> producers;
+  for (int t = 0; t < kThreads; t++)
+  {
+    producers.emplace_back([&, t]() {
+      std::mt19937 random(round * kThreads + t);
+      std::vector<int> keys(kKeys);
+      for (int i = 0; i < kKeys; i++)
+        keys[i] = i;
+      std::shuffle(keys.begin(), keys.end(), random);
+      keys.resize(kKeysPerThread);
+      while (!go.load())
+        std::this_thread::yield();
+      for (int i : keys)
+      {
+        std::string name = keyName(i);
+        std::pair<const std::string *, bool> inserted =
+            t % 2 == 0 ? list.tryInsert(name) : list.tryInsert(std::move(name));
+        if (inserted.second)
+          added[i].fetch_add(1);
+        if (*inserted.first != keyName(i))
+          added[i].store(kThreads + 1); // returned the wrong entry
+      }
+    });
+  }
+  go.store(true);
+  for (std::thread &producer : producers)
+    producer.join();
+
+  bool passed = true;
+  int stored = 0;
+  const std::string *previous = nullptr;
+  list.forEach([&](const std::string &name) {
+    if (previous != nullptr && !(*previous < name))
+    {
+      std::printf("round %d: \"%s\" follows \"%s\"\n", round, name.c_str(), previous->c_str());
+      passed = false;
+    }
+    previous = &name;
+    stored++;
+  });
+  int expected = 0;
+  for (int i = 0; i < kKeys; i++)
+  {
+    bool tried = list.contains(keyName(i));
+    expected += tried;
+    if (added[i].load() != (tried ? 1 : 0))
+    {
+      std::printf("round %d: key %d reported added %d times\n", round, i, added[i].load());
+      passed = false;
+    }
+  }
+  if (stored != expected || stored != list.getNumberOfNodes())
+  {
+    std::printf("round %d: %d entries stored, %d distinct keys\n", round, stored, expected);
+    passed = false;
+  }
+  std::vector<std::string> drained = list.takeAll();
+  if (static_cast<int>(drained.size()) != stored || !std::is_sorted(drained.begin(), drained.end()) || !list.isEmpty())
+  {
+    std::printf("round %d: takeAll returned %zu entries\n", round, drained.size());
+    passed = false;
+  }
+  return passed;
+}
+} // namespace
+
+int main()
+{
+  bool passed = true;
+  for (int round = 0; round < kRounds; round++)
+    passed = runRound(round) && passed;
+  std::printf("%s: %d rounds, %d threads, %d keys\n", passed ? "passed" : "FAILED", kRounds, kThreads, kKeys);
+  return passed ? 0 : 1;
+}
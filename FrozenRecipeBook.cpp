@@ -0,0 +1,95 @@
+/** @file FrozenRecipeBook.cpp */
+
+#include "FrozenRecipeBook.hpp"
+
+FrozenRecipeBook::FrozenRecipeBook()
+{
+} // end default constructor
+
+FrozenRecipeBook::FrozenRecipeBook(const RecipeBook &book) : recipes_(book.begin(), book.end())
+{
+  if (!recipes_.empty())
+  {
+    // The names are sorted, so what the first and last share, all share
+    std::string_view first = recipes_.front().name_;
+    std::string_view last = recipes_.back().name_;
+    std::size_t length = 0;
+    while (length < first.size() && length < last.size() && first[length] == last[length])
+      length++;
+    shared_prefix_ = std::string(first.substr(0, length));
+  }
+  prefixes_.resize(recipes_.size() + 1);
+  ranks_.resize(recipes_.size() + 1);
+  std::uint32_t rank = 0;
+  fill(1, rank);
+} // end constructor
+
+const Recipe *FrozenRecipeBook::findRecipe(std::string_view name) const
+{
+  if (name.substr(0, shared_prefix_.size()) != shared_prefix_)
+    return nullptr; // every name starts with shared_prefix_
+  const std::uint64_t target = prefixOf(name);
+  const std::uint64_t *prefixes = prefixes_.data();
+  const std::size_t count = recipes_.size();
+  std::size_t slot = 1;
+  while (slot <= count)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    // The 16 great-grandchildren of slot are 128 contiguous bytes
+    __builtin_prefetch(prefixes + slot * 16);
+#endif
+    std::uint64_t prefix = prefixes[slot];
+    bool go_right = prefix < target || (prefix == target && std::string_view(recipes_[ranks_[slot]].name_) < name);
+    slot = 2 * slot + go_right;
+  }
+  // Undo the right turns after the last left turn; that node is the first
+  // one not less than name
+  while (slot & 1)
+    slot >>= 1;
+  slot >>= 1;
+  if (slot == 0)
+    return nullptr;
+  const Recipe &recipe = recipes_[ranks_[slot]];
+  return recipe.name_ == name ? &recipe : nullptr;
+} // end findRecipe
+
+bool FrozenRecipeBook::contains(std::string_view name) const
+{
+  return findRecipe(name) != nullptr;
+} // end contains
+
+const std::vector<Recipe> &FrozenRecipeBook::getRecipes() const
+{
+  return recipes_;
+} // end getRecipes
+
+std::size_t FrozenRecipeBook::size() const
+{
+  return recipes_.size();
+} // end size
+
+bool FrozenRecipeBook::isEmpty() const
+{
+  return recipes_.empty();
+} // end isEmpty
+
+std::uint64_t FrozenRecipeBook::prefixOf(std::string_view name) const
+{
+  name.remove_prefix(shared_prefix_.size());
+  std::uint64_t prefix = 0;
+  for (std::size_t i = 0; i < 8; i++)
+    prefix = (prefix << 8) | (i < name.size() ? static_cast<unsigned char>(name[i]) : 0);
+  return prefix;
+} // end prefixOf
+
+void FrozenRecipeBook::fill(std::size_t slot, std::uint32_t &rank)
+{
+  // In-order walk of the implicit tree; its depth is only O(log n)
+  if (slot > recipes_.size())
+    return;
+  fill(2 * slot, rank);
+  prefixes_[slot] = prefixOf(recipes_[rank].name_);
+  ranks_[slot] = rank;
+  rank++;
+  fill(2 * slot + 1, rank);
+} // end fill
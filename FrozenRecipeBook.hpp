@@ -0,0 +1,67 @@
+/** An immutable, read-optimized copy of a RecipeBook for lookup-heavy use.
+ The Recipes are stored once, sorted by name, in one contiguous array. The
+ search keys are laid out separately in Eytzinger (breadth-first) order:
+ the children of slot k are slots 2k and 2k+1, so the top levels of the
+ tree share a few cache lines and the next levels can be prefetched before
+ they are needed. Each slot holds 8 bytes of a name packed into an integer,
+ taken after the prefix every name shares, so most steps are a single
+ integer compare; the full names are only compared when those bytes are equal.
+ @file FrozenRecipeBook.hpp */
+
+#ifndef FROZEN_RECIPE_BOOK_
+#define FROZEN_RECIPE_BOOK_
+
+#include "RecipeBook.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class FrozenRecipeBook
+{
+public:
+  FrozenRecipeBook();
+
+  /** @param book the book to copy
+      @post holds a copy of every Recipe in book, in O(n) **/
+  explicit FrozenRecipeBook(const RecipeBook &book);
+
+  /** @param name the name to look up
+      @return the Recipe with that name, nullptr if not found; the search is
+              one branch-free descent of the Eytzinger array **/
+  const Recipe *findRecipe(std::string_view name) const;
+
+  /** @param name the name to look up
+      @return true if a Recipe with that name is in the book **/
+  bool contains(std::string_view name) const;
+
+  /** @return the Recipes, sorted by name **/
+  const std::vector<Recipe> &getRecipes() const;
+
+  /** @return the number of Recipes **/
+  std::size_t size() const;
+
+  /** @return true if there are no Recipes **/
+  bool isEmpty() const;
+
+private:
+  std::vector<Recipe> recipes_;          // sorted by name
+  std::vector<std::uint64_t> prefixes_;  // Eytzinger order, slot 0 unused
+  std::vector<std::uint32_t> ranks_;     // index into recipes_ of each slot
+  std::string shared_prefix_;            // the longest prefix of every name
+
+  /** @param name a name starting with shared_prefix_
+      @return the 8 bytes of name after shared_prefix_ as a big-endian
+              integer, zero padded, so integer order agrees with the order
+              of the names **/
+  std::uint64_t prefixOf(std::string_view name) const;
+
+  /** called by the constructor
+      @param slot the Eytzinger slot to fill, with its subtree
+      @param rank the next index of recipes_ to place
+      @post the subtree at slot is filled in order, and rank moved past it **/
+  void fill(std::size_t slot, std::uint32_t &rank);
+};
+
+#endif
@@ -0,0 +1,20 @@
+/** Key extraction for BinarySearchTree.
+ The tree orders items by KeyPolicy::key(item) compared with std::less<>,
+ so lookups can take anything that compares with that key (for example a
+ std::string_view name) without building a whole item first.
+ @file KeyPolicy.hpp */
+
+#ifndef KEY_POLICY_
+#define KEY_POLICY_
+
+/** The item is its own key, ordered by its operator<. **/
+struct IdentityKey
+{
+  template <class T>
+  static const T &key(const T &item)
+  {
+    return item;
+  }
+};
+
+#endif
@@ -0,0 +1,88 @@
+/** Counts the heap allocations and times the lookups of a RecipeBook.
+ Every call to operator new in this program is counted, so the numbers
+ printed for findRecipe and calculateMasteryPoints show whether a lookup
+ allocates anything. Build and run with "make bench".
+ @file LookupBench.cpp */
+
+#include "RecipeBook.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+std::size_t allocations = 0; // single-threaded: the lookups run on main only
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+void *operator new(std::size_t bytes)
+{
+  allocations++;
+  if (void *memory = std::malloc(bytes == 0 ? 1 : bytes))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+  std::free(memory);
+}
+
+int main(int argc, char *argv[])
+{
+  const int recipes = argc > 1 ? std::atoi(argv[1]) : 200000;
+  const int lookups = 1000000;
+
+  // Names longer than the inline capacity of RecipeText, so the ones that
+  // live in shared blocks are measured too
+  std::mt19937 random(42);
+  std::vector<std::string> names;
+  for (int i = 0; i < recipes; i++)
+    names.push_back((i % 2 ? "recipe number " : "r") + std::to_string(random()));
+  RecipeBook book;
+  for (int i = 0; i < recipes; i++)
+    book.addRecipe(Recipe(names[i], i % 10, "a description shared by many recipes", i % 3 == 0));
+
+  std::vector<const std::string *> queries; // half of them miss
+  std::vector<std::string> missing;
+  for (int i = 0; i < lookups / 2; i++)
+    missing.push_back("missing " + std::to_string(i));
+  for (int i = 0; i < lookups; i++)
+    queries.push_back(i % 2 ? &names[random() % names.size()] : &missing[i / 2]);
+
+  std::size_t before = allocations;
+  auto start = std::chrono::steady_clock::now();
+  std::size_t found = 0;
+  for (const std::string *name : queries)
+    found += book.findRecipe(*name) != nullptr;
+  double find_seconds = secondsSince(start);
+  std::size_t find_allocations = allocations - before;
+
+  before = allocations;
+  start = std::chrono::steady_clock::now();
+  long points = 0;
+  for (const std::string *name : queries)
+    points += book.calculateMasteryPoints(*name);
+  double mastery_seconds = secondsSince(start);
+  std::size_t mastery_allocations = allocations - before;
+
+  std::printf("%d recipes, %d lookups (%zu found)\n", recipes, lookups, found);
+  std::printf("findRecipe:             %zu allocations, %.1f ns per lookup\n", find_allocations,
+              find_seconds * 1e9 / lookups);
+  std::printf("calculateMasteryPoints: %zu allocations, %.1f ns per lookup (checksum %ld)\n", mastery_allocations,
+              mastery_seconds * 1e9 / lookups, points);
+  return find_allocations == 0 && mastery_allocations == 0 ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+/** @file MappedFile.cpp */
+
+#include "MappedFile.hpp"
+#include <fstream>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_USE_MMAP 1
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : data_(nullptr), size_(0), mapped_(false)
+{
+} // end default constructor
+
+MappedFile::~MappedFile()
+{
+  close();
+} // end destructor
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : data_(other.data_), size_(other.size_), mapped_(other.mapped_), buffer_(std::move(other.buffer_))
+{
+  if (!mapped_)
+    data_ = buffer_.data();
+  other.data_ = nullptr;
+  other.size_ = 0;
+  other.mapped_ = false;
+} // end move constructor
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+  if (this != &other)
+  {
+    close();
+    data_ = other.data_;
+    size_ = other.size_;
+    mapped_ = other.mapped_;
+    buffer_ = std::move(other.buffer_);
+    if (!mapped_)
+      data_ = buffer_.data();
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.mapped_ = false;
+  }
+  return *this;
+} // end operator=
+
+bool MappedFile::open(const std::string &filename, std::string &error, Access access)
+{
+  close();
+#ifdef MAPPED_FILE_USE_MMAP
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    error = "cannot open " + filename + ": " + std::strerror(errno);
+    return false;
+  }
+  struct stat info;
+  if (::fstat(fd, &info) != 0)
+  {
+    error = "cannot stat " + filename + ": " + std::strerror(errno);
+    ::close(fd);
+    return false;
+  }
+  if (info.st_size > 0)
+  {
+    void *address = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address != MAP_FAILED)
+    {
+      data_ = static_cast<const char *>(address);
+      size_ = static_cast<std::size_t>(info.st_size);
+      mapped_ = true;
+      advise(access);
+      ::close(fd);
+      return true;
+    }
+  }
+  ::close(fd);
+  if (info.st_size == 0)
+    return true; // nothing to map
+#endif
+  // No mmap: read the whole file in one block
+  std::ifstream fin(filename, std::ios::binary | std::ios::ate);
+  if (fin.fail())
+  {
+    error = "cannot open " + filename;
+    return false;
+  }
+  std::streamoff length = fin.tellg();
+  buffer_.resize(length > 0 ? static_cast<std::size_t>(length) : 0);
+  fin.seekg(0);
+  if (!buffer_.empty() && !fin.read(&buffer_[0], static_cast<std::streamsize>(buffer_.size())))
+  {
+    error = "cannot read " + filename;
+    buffer_.clear();
+    return false;
+  }
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+  return true;
+} // end open
+
+void MappedFile::advise(Access access)
+{
+#ifdef MAPPED_FILE_USE_MMAP
+  if (mapped_)
+    ::madvise(const_cast<char *>(data_), size_, access == RANDOM ? MADV_RANDOM : MADV_SEQUENTIAL);
+#else
+  (void)access;
+#endif
+} // end advise
+
+void MappedFile::close()
+{
+#ifdef MAPPED_FILE_USE_MMAP
+  if (mapped_)
+    ::munmap(const_cast<char *>(data_), size_);
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  mapped_ = false;
+  buffer_.clear();
+} // end close
+
+std::string_view MappedFile::getContents() const
+{
+  return std::string_view(data_, size_);
+} // end getContents
+
+bool MappedFile::syncPath(const std::string &filename)
+{
+#ifdef MAPPED_FILE_USE_MMAP
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  bool synced = ::fsync(fd) == 0;
+  ::close(fd);
+  return synced;
+#else
+  (void)filename;
+  return true; // nothing portable to call; the OS writes the file back in its own time
+#endif
+} // end syncPath
@@ -0,0 +1,61 @@
+/** Read-only view of a whole file.
+ On POSIX systems the file is memory-mapped, so its bytes are paged in by
+ the kernel as they are read; elsewhere it is read into a buffer with one
+ block read.
+ @file MappedFile.hpp */
+
+#ifndef MAPPED_FILE_
+#define MAPPED_FILE_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+class MappedFile
+{
+public:
+  /** How the bytes will be read, so the kernel reads ahead (or not) to suit **/
+  enum Access
+  {
+    SEQUENTIAL, // front to back once: read ahead aggressively, drop pages behind
+    RANDOM      // scattered lookups: read only the pages touched
+  };
+
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  /** @param filename the file to open
+      @param error set to a message when the file cannot be opened
+      @param access how the bytes will be read
+      @post any previously opened file is closed
+      @return true if the file is open and its bytes are available **/
+  bool open(const std::string &filename, std::string &error, Access access = SEQUENTIAL);
+
+  /** @param access how the bytes will be read from now on
+      @post the kernel is told, if the file is mapped **/
+  void advise(Access access);
+
+  /** @post the mapping or buffer is released **/
+  void close();
+
+  /** @return the bytes of the file; empty if nothing is open **/
+  std::string_view getContents() const;
+
+  /** @param filename a file or directory
+      @return true if its contents (for a directory, its entries) are synced
+              to disk; true without syncing where there is no fsync **/
+  static bool syncPath(const std::string &filename);
+
+private:
+  const char *data_;
+  std::size_t size_;
+  bool mapped_;        // true if data_ came from mmap, false if it is buffer_
+  std::string buffer_; // used when mmap is unavailable
+};
+
+#endif
@@ -0,0 +1,279 @@
+/** @file MappedRecipeBook.cpp */
+
+#include "MappedRecipeBook.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+const char kMagic[8] = {'R', 'C', 'P', 'B', 'O', 'O', 'K', '\0'};
+const std::uint32_t kByteOrderMark = 0x01020304;
+const std::uint64_t kChecksumSeed = 0xcbf29ce484222325ULL;
+
+// Byte offsets of the header fields
+const std::size_t kVersionAt = 8, kByteOrderAt = 12, kRecordSizeAt = 16, kCountAt = 24, kPoolSizeAt = 32, kChecksumAt = 40;
+// Byte offsets of the fields of a record
+const std::size_t kPackedNameAt = 0, kNameOffsetAt = 8, kDescriptionOffsetAt = 16, kNameLengthAt = 24,
+                  kDescriptionLengthAt = 28, kDifficultyAt = 32, kMasteredAt = 36;
+
+/** @return the U stored at data; memcpy makes no alignment assumption and
+            compiles to a single load **/
+template <class U>
+U readAt(const char *data)
+{
+  U value;
+  std::memcpy(&value, data, sizeof(U));
+  return value;
+} // end readAt
+
+template <class U>
+void writeAt(char *data, U value)
+{
+  std::memcpy(data, &value, sizeof(U));
+} // end writeAt
+} // namespace
+
+Recipe RecipeView::toRecipe() const
+{
+  return Recipe(RecipeText(name_), difficulty_level_, RecipeText(description_), mastered_);
+} // end toRecipe
+
+MappedRecipeBook::MappedRecipeBook() : records_(nullptr), count_(0), pool_(nullptr), pool_size_(0)
+{
+} // end default constructor
+
+bool MappedRecipeBook::save(const RecipeBook &book, const std::string &filename, std::string &error)
+{
+  // The records and pool are laid out in memory first, so the checksum can
+  // go in the header ahead of them
+  std::size_t count = book.getNumberOfNodes();
+  std::string records(count * kRecordSize, '\0');
+  std::string pool;
+  char *record = &records[0];
+  for (const Recipe &recipe : book)
+  {
+    writeAt<std::uint64_t>(record + kPackedNameAt, packName(recipe.name_));
+    writeAt<std::uint64_t>(record + kNameOffsetAt, pool.size());
+    writeAt<std::uint32_t>(record + kNameLengthAt, static_cast<std::uint32_t>(recipe.name_.size()));
+    pool += recipe.name_;
+    writeAt<std::uint64_t>(record + kDescriptionOffsetAt, pool.size());
+    writeAt<std::uint32_t>(record + kDescriptionLengthAt, static_cast<std::uint32_t>(recipe.description_.size()));
+    pool += recipe.description_;
+    writeAt<std::int32_t>(record + kDifficultyAt, recipe.difficulty_level_);
+    writeAt<std::uint32_t>(record + kMasteredAt, recipe.mastered_ ? 1 : 0);
+    record += kRecordSize;
+  }
+
+  char header[kHeaderSize] = {};
+  std::memcpy(header, kMagic, sizeof(kMagic));
+  writeAt<std::uint32_t>(header + kVersionAt, kVersion);
+  writeAt<std::uint32_t>(header + kByteOrderAt, kByteOrderMark);
+  writeAt<std::uint32_t>(header + kRecordSizeAt, kRecordSize);
+  writeAt<std::uint64_t>(header + kCountAt, count);
+  writeAt<std::uint64_t>(header + kPoolSizeAt, pool.size());
+  std::uint64_t sum = checksum(records.data(), records.size(), kChecksumSeed);
+  writeAt<std::uint64_t>(header + kChecksumAt, checksum(pool.data(), pool.size(), sum));
+
+  // Written next to the old file, then renamed over it in one step
+  std::string temporary = filename + ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(header, kHeaderSize);
+    out.write(records.data(), records.size());
+    out.write(pool.data(), pool.size());
+    out.close();
+    if (!out)
+    {
+      error = "cannot write " + temporary;
+      std::remove(temporary.c_str());
+      return false;
+    }
+  }
+  // The contents must be on disk before the rename is, or a crash could
+  // leave an empty or partial book under the final name
+  if (!MappedFile::syncPath(temporary))
+  {
+    error = "cannot sync " + temporary + ": " + std::strerror(errno);
+    std::remove(temporary.c_str());
+    return false;
+  }
+  if (std::rename(temporary.c_str(), filename.c_str()) != 0)
+  {
+    error = "cannot replace " + filename + ": " + std::strerror(errno);
+    std::remove(temporary.c_str());
+    return false;
+  }
+  std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+  MappedFile::syncPath(directory.empty() ? std::string(".") : directory.string()); // the rename itself
+  return true;
+} // end save
+
+bool MappedRecipeBook::open(const std::string &filename, std::string &error, bool verify)
+{
+  close();
+  // Verifying reads the file front to back; lookups binary-search it after
+  if (!file_.open(filename, error, verify ? MappedFile::SEQUENTIAL : MappedFile::RANDOM))
+    return false;
+  std::string_view contents = file_.getContents();
+  if (contents.size() < kHeaderSize || std::memcmp(contents.data(), kMagic, sizeof(kMagic)) != 0)
+  {
+    error = filename + ": not a saved recipe book";
+    close();
+    return false;
+  }
+  const char *header = contents.data();
+  if (readAt<std::uint32_t>(header + kVersionAt) != kVersion)
+  {
+    error = filename + ": format version " + std::to_string(readAt<std::uint32_t>(header + kVersionAt)) +
+            ", expected " + std::to_string(kVersion);
+    close();
+    return false;
+  }
+  if (readAt<std::uint32_t>(header + kByteOrderAt) != kByteOrderMark)
+  {
+    error = filename + ": saved on a machine with a different byte order";
+    close();
+    return false;
+  }
+  std::uint64_t count = readAt<std::uint64_t>(header + kCountAt);
+  std::uint64_t pool_size = readAt<std::uint64_t>(header + kPoolSizeAt);
+  std::size_t body_size = contents.size() - kHeaderSize;
+  if (readAt<std::uint32_t>(header + kRecordSizeAt) != kRecordSize || count > body_size / kRecordSize ||
+      pool_size != body_size - count * kRecordSize)
+  {
+    error = filename + ": truncated or damaged";
+    close();
+    return false;
+  }
+
+  const char *records = header + kHeaderSize;
+  const char *pool = records + count * kRecordSize;
+  if (verify)
+  {
+    std::uint64_t sum = checksum(records, count * kRecordSize, kChecksumSeed);
+    if (checksum(pool, pool_size, sum) != readAt<std::uint64_t>(header + kChecksumAt))
+    {
+      error = filename + ": checksum mismatch";
+      close();
+      return false;
+    }
+    for (std::size_t i = 0; i < count; i++)
+    {
+      // A record is valid if its strings lie inside the pool
+      const char *record = records + i * kRecordSize;
+      std::uint64_t name_offset = readAt<std::uint64_t>(record + kNameOffsetAt);
+      std::uint64_t description_offset = readAt<std::uint64_t>(record + kDescriptionOffsetAt);
+      if (name_offset > pool_size || readAt<std::uint32_t>(record + kNameLengthAt) > pool_size - name_offset ||
+          description_offset > pool_size || readAt<std::uint32_t>(record + kDescriptionLengthAt) > pool_size - description_offset)
+      {
+        error = filename + ": record " + std::to_string(i) + " points outside the string pool";
+        close();
+        return false;
+      }
+    }
+  }
+
+  if (verify)
+    file_.advise(MappedFile::RANDOM);
+  records_ = records;
+  count_ = count;
+  pool_ = pool;
+  pool_size_ = pool_size;
+  return true;
+} // end open
+
+void MappedRecipeBook::close()
+{
+  file_.close();
+  records_ = nullptr;
+  count_ = 0;
+  pool_ = nullptr;
+  pool_size_ = 0;
+} // end close
+
+std::optional<RecipeView> MappedRecipeBook::findRecipe(std::string_view name) const
+{
+  // Lower bound over the records; the packed names settle most steps
+  // without touching the pool
+  const std::uint64_t target = packName(name);
+  std::size_t first = 0, length = count_;
+  while (length > 0)
+  {
+    std::size_t half = length / 2;
+    std::size_t middle = first + half;
+    std::uint64_t packed = packedNameAt(middle);
+    if (packed < target || (packed == target && nameAt(middle) < name))
+    {
+      first = middle + 1;
+      length -= half + 1;
+    }
+    else
+      length = half;
+  }
+  if (first == count_ || nameAt(first) != name)
+    return std::nullopt;
+  return getRecipe(first);
+} // end findRecipe
+
+bool MappedRecipeBook::contains(std::string_view name) const
+{
+  return findRecipe(name).has_value();
+} // end contains
+
+RecipeView MappedRecipeBook::getRecipe(std::size_t i) const
+{
+  const char *record = records_ + i * kRecordSize;
+  RecipeView view;
+  view.name_ = nameAt(i);
+  view.difficulty_level_ = readAt<std::int32_t>(record + kDifficultyAt);
+  view.description_ = std::string_view(pool_ + readAt<std::uint64_t>(record + kDescriptionOffsetAt),
+                                       readAt<std::uint32_t>(record + kDescriptionLengthAt));
+  view.mastered_ = readAt<std::uint32_t>(record + kMasteredAt) != 0;
+  return view;
+} // end getRecipe
+
+std::size_t MappedRecipeBook::size() const
+{
+  return count_;
+} // end size
+
+bool MappedRecipeBook::isEmpty() const
+{
+  return count_ == 0;
+} // end isEmpty
+
+std::uint64_t MappedRecipeBook::packName(std::string_view name)
+{
+  std::uint64_t packed = 0;
+  for (std::size_t i = 0; i < 8; i++)
+    packed = (packed << 8) | (i < name.size() ? static_cast<unsigned char>(name[i]) : 0);
+  return packed;
+} // end packName
+
+std::uint64_t MappedRecipeBook::checksum(const char *data, std::size_t size, std::uint64_t sum)
+{
+  // FNV-1a over 8-byte words: each step is a bijection of sum, so any one
+  // changed word changes the result
+  const std::uint64_t prime = 0x100000001b3ULL;
+  std::size_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    sum = (sum ^ readAt<std::uint64_t>(data + i)) * prime;
+  std::uint64_t tail = size - i; // the length goes in with the last bytes
+  for (; i < size; i++)
+    tail = (tail << 8) | static_cast<unsigned char>(data[i]);
+  return (sum ^ tail) * prime;
+} // end checksum
+
+std::uint64_t MappedRecipeBook::packedNameAt(std::size_t i) const
+{
+  return readAt<std::uint64_t>(records_ + i * kRecordSize + kPackedNameAt);
+} // end packedNameAt
+
+std::string_view MappedRecipeBook::nameAt(std::size_t i) const
+{
+  const char *record = records_ + i * kRecordSize;
+  return std::string_view(pool_ + readAt<std::uint64_t>(record + kNameOffsetAt), readAt<std::uint32_t>(record + kNameLengthAt));
+} // end nameAt
@@ -0,0 +1,109 @@
+/** A read-only RecipeBook served straight from a file saved by RecipeBook::save.
+ The file is memory-mapped (see MappedFile.hpp) and never parsed: lookups
+ binary-search its record array in place and hand back views into its
+ string pool, so opening a book costs no allocation per Recipe.
+ Layout, in the byte order of the machine that wrote it:
+   Header  magic "RCPBOOK", format version, byte order mark, record size,
+           record count, pool size, and a checksum of everything after it
+   Record  one per Recipe, sorted by name, each kRecordSize bytes: the first
+           8 bytes of the name packed into a big-endian integer (so integer
+           order agrees with name order), then the offset and length of the
+           name and of the description in the pool, difficulty_level_ and
+           mastered_
+   Pool    the names and descriptions, back to back
+ @file MappedRecipeBook.hpp */
+
+#ifndef MAPPED_RECIPE_BOOK_
+#define MAPPED_RECIPE_BOOK_
+
+#include "MappedFile.hpp"
+#include "RecipeBook.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/** The fields of a Recipe, viewed in place in a MappedRecipeBook; valid as
+    long as the book stays open **/
+struct RecipeView
+{
+  std::string_view name_;
+  int difficulty_level_;
+  std::string_view description_;
+  bool mastered_;
+
+  /** @return a Recipe holding copies of the fields **/
+  Recipe toRecipe() const;
+};
+
+class MappedRecipeBook
+{
+public:
+  static constexpr std::uint32_t kVersion = 1;     // bumped whenever the layout changes
+  static constexpr std::size_t kHeaderSize = 48;
+  static constexpr std::size_t kRecordSize = 40;
+
+  MappedRecipeBook();
+
+  /** @param book the book to save
+      @param filename the file to write; it is replaced only once the new
+             contents are complete, so readers never see half a book
+      @param error set to a message if the file cannot be written
+      @return true if the file was written **/
+  static bool save(const RecipeBook &book, const std::string &filename, std::string &error);
+
+  /** @param filename a file written by save
+      @param error set to a message if the file cannot be opened or is not a
+             valid book of this version
+      @param verify false to skip the checksum and bounds checks, which read
+             the whole file once; the file is then trusted, and opening is O(1)
+      @post any previously opened book is closed
+      @return true if the book is open **/
+  bool open(const std::string &filename, std::string &error, bool verify = true);
+
+  /** @post the file is unmapped and the book is empty **/
+  void close();
+
+  /** @param name the name to look up
+      @return the Recipe with that name, found by one binary search of the
+              mapped records; nothing if not found **/
+  std::optional<RecipeView> findRecipe(std::string_view name) const;
+
+  /** @param name the name to look up
+      @return true if a Recipe with that name is in the book **/
+  bool contains(std::string_view name) const;
+
+  /** @param i a position in name order, less than size()
+      @return the Recipe with i smaller names **/
+  RecipeView getRecipe(std::size_t i) const;
+
+  /** @return the number of Recipes **/
+  std::size_t size() const;
+
+  /** @return true if there are no Recipes **/
+  bool isEmpty() const;
+
+private:
+  MappedFile file_;
+  const char *records_;  // the record array inside the mapping
+  std::size_t count_;
+  const char *pool_;     // the string pool inside the mapping
+  std::size_t pool_size_;
+
+  /** @return the 8 bytes of name from the start as a big-endian integer, zero padded **/
+  static std::uint64_t packName(std::string_view name);
+
+  /** @param sum the checksum of the bytes before data, or a fixed seed
+      @return the checksum of those bytes followed by size bytes at data,
+              read 8 at a time **/
+  static std::uint64_t checksum(const char *data, std::size_t size, std::uint64_t sum);
+
+  /** @return the packed name of record i **/
+  std::uint64_t packedNameAt(std::size_t i) const;
+
+  /** @return the name of record i, viewed in the pool **/
+  std::string_view nameAt(std::size_t i) const;
+};
+
+#endif
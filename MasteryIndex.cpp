@@ -0,0 +1,55 @@
+/** @file MasteryIndex.cpp */
+
+#include "MasteryIndex.hpp"
+
+void MasteryIndex::add(int difficulty)
+{
+  recount(difficulty, 1);
+} // end add
+
+bool MasteryIndex::remove(int difficulty)
+{
+  return recount(difficulty, -1);
+} // end remove
+
+int MasteryIndex::countAtMost(int difficulty) const
+{
+  // rank weighs every level below difficulty by its count; the level itself is added on
+  const MasteryLevel *level = levels_.findItem(difficulty);
+  return static_cast<int>(levels_.rank(difficulty)) + (level == nullptr ? 0 : level->count);
+} // end countAtMost
+
+int MasteryIndex::getCount() const
+{
+  return levels_.getNumberOfNodes(); // the root's size, which counts recipes
+} // end getCount
+
+void MasteryIndex::clear()
+{
+  levels_.clear();
+} // end clear
+
+MasteryIndex MasteryIndex::snapshot()
+{
+  MasteryIndex shared;
+  shared.levels_ = levels_.snapshot();
+  return shared;
+} // end snapshot
+
+
+/*PRIVATE METHODS*/
+
+bool MasteryIndex::recount(int difficulty, int change)
+{
+  const MasteryLevel *level = levels_.findItem(difficulty);
+  int count = (level == nullptr ? 0 : level->count) + change;
+  if (count < 0)
+    return false;
+  if (level == nullptr)
+    levels_.tryInsert(MasteryLevel{difficulty, count});
+  else if (count == 0)
+    levels_.erase(difficulty);
+  else
+    levels_.replace(MasteryLevel{difficulty, count}); // also fixes the subtree sizes above it
+  return true;
+} // end recount
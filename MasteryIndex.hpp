@@ -0,0 +1,72 @@
+/** Secondary index of unmastered recipes keyed by difficulty level.
+ A BinarySearchTree with AvlPolicy and one node per distinct difficulty;
+ each node's item weighs as many entries as there are unmastered recipes
+ at its difficulty (see ItemWeight), so the subtree sizes the tree keeps
+ count recipes and "how many unmastered recipes are at or below
+ difficulty d" is a rank query on a single root-to-leaf path.
+ Like the tree, the index can be shared: snapshot() is O(1), and each
+ version copies only the path it changes.
+ @file MasteryIndex.hpp */
+
+#ifndef MASTERY_INDEX_
+#define MASTERY_INDEX_
+
+#include "BinarySearchTree.hpp"
+
+/** The unmastered recipes at one difficulty level **/
+struct MasteryLevel
+{
+  int difficulty;
+  int count;
+};
+
+template <>
+struct ItemWeight<MasteryLevel>
+{
+  static int of(const MasteryLevel &level) { return level.count; }
+};
+
+class MasteryIndex
+{
+public:
+  /** @param difficulty the difficulty of an unmastered recipe
+      @post the recipe is counted **/
+  void add(int difficulty);
+
+  /** @param difficulty the difficulty of an unmastered recipe that was counted
+      @post the recipe is no longer counted
+      @return false if nothing was counted at that difficulty **/
+  bool remove(int difficulty);
+
+  /** @param difficulty the highest difficulty to count
+      @return the number of counted recipes with difficulty <= difficulty, in O(log n) **/
+  int countAtMost(int difficulty) const;
+
+  /** @return the number of counted recipes **/
+  int getCount() const;
+
+  /** @post nothing is counted **/
+  void clear();
+
+  /** @return an index counting the same recipes, in O(1); the two share
+              their nodes, and neither sees the other's changes **/
+  MasteryIndex snapshot();
+
+private:
+  /** Orders levels by difficulty **/
+  struct DifficultyKey
+  {
+    static const int &key(const MasteryLevel &level) { return level.difficulty; }
+  };
+
+  BinarySearchTree<MasteryLevel, AvlPolicy, NodePoolAllocator<BinaryNode<MasteryLevel>>, DifficultyKey> levels_;
+
+  /** @param difficulty a difficulty level
+      @param change how many recipes to count at it; negative to stop counting some
+      @post the level's count is changed in place, or the level added or
+            dropped
+      @return false if fewer than -change recipes were counted at it **/
+  bool recount(int difficulty, int change);
+};
+
+#endif
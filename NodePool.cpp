@@ -0,0 +1,176 @@
+/** @file NodePool.cpp */
+
+#include "NodePool.hpp"
+
+struct NodeDepot::Cache
+{
+  FreeBlock *free_list = nullptr;
+  std::size_t free_count = 0;
+  unsigned char *bump = nullptr;     // next never-used block in the slab being carved
+  unsigned char *bump_end = nullptr;
+};
+
+/** The calling thread's caches, one per depot **/
+struct ThreadCaches
+{
+  std::vector<NodeDepot::Cache> caches;
+  ~ThreadCaches();
+};
+
+namespace
+{
+const std::size_t kNodesPerSlab = 1024;
+
+std::mutex registry_mutex;
+
+thread_local ThreadCaches thread_caches;
+thread_local bool thread_caches_gone = false; // trivially destructible, so readable during thread exit
+
+/** @return every depot made so far; a function static, so books built
+            during static initialization can use it, and never destroyed **/
+std::vector<NodeDepot *> &depots()
+{
+  static std::vector<NodeDepot *> *made = new std::vector<NodeDepot *>();
+  return *made;
+}
+
+NodeDepot *depotAt(std::size_t index)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  return depots()[index];
+}
+} // namespace
+
+ThreadCaches::~ThreadCaches()
+{
+  for (std::size_t i = 0; i < caches.size(); i++)
+  {
+    NodeDepot::Cache &cache = caches[i];
+    NodeDepot *depot = depotAt(i);
+    // The rest of the slab being carved goes back as freed blocks
+    for (; cache.bump != cache.bump_end; cache.bump += depot->block_size_)
+    {
+      NodeDepot::FreeBlock *freed = reinterpret_cast<NodeDepot::FreeBlock *>(cache.bump);
+      freed->next = cache.free_list;
+      cache.free_list = freed;
+      cache.free_count++;
+    }
+    depot->giveBack(cache);
+  }
+  thread_caches_gone = true;
+} // end destructor
+
+NodeDepot &NodeDepot::forSize(std::size_t bytes)
+{
+  // Round up so every block stays aligned for any scalar type
+  const std::size_t align = alignof(std::max_align_t);
+  std::size_t size = bytes < sizeof(FreeBlock) ? sizeof(FreeBlock) : bytes;
+  size = (size + align - 1) / align * align;
+
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  std::vector<NodeDepot *> &made = depots();
+  for (NodeDepot *depot : made)
+  {
+    if (depot->block_size_ == size)
+      return *depot;
+  }
+  made.push_back(new NodeDepot(size, made.size()));
+  return *made.back();
+} // end forSize
+
+NodeDepot::NodeDepot(std::size_t block_size, std::size_t index)
+    : block_size_(block_size), nodes_per_slab_(kNodesPerSlab), index_(index)
+{
+} // end constructor
+
+void *NodeDepot::allocate()
+{
+  if (thread_caches_gone)
+    return ::operator new(block_size_); // joins the pool when it is freed
+  std::vector<Cache> &caches = thread_caches.caches;
+  if (index_ >= caches.size())
+    caches.resize(index_ + 1);
+  Cache &cache = caches[index_];
+
+  if (cache.free_list == nullptr)
+  {
+    if (cache.bump == cache.bump_end)
+      refill(cache);
+    if (cache.free_list == nullptr)
+    {
+      void *block = cache.bump;
+      cache.bump += block_size_;
+      return block;
+    }
+  }
+  FreeBlock *block = cache.free_list;
+  cache.free_list = block->next;
+  cache.free_count--;
+  return block;
+} // end allocate
+
+void NodeDepot::deallocate(void *block)
+{
+  if (thread_caches_gone)
+  {
+    giveBack(block);
+    return;
+  }
+  std::vector<Cache> &caches = thread_caches.caches;
+  if (index_ >= caches.size())
+    caches.resize(index_ + 1);
+  Cache &cache = caches[index_];
+
+  FreeBlock *freed = static_cast<FreeBlock *>(block);
+  freed->next = cache.free_list;
+  cache.free_list = freed;
+  // A thread that only frees (a reader dropping old snapshots) hands its
+  // blocks on instead of keeping them from the threads that allocate
+  if (++cache.free_count >= 2 * nodes_per_slab_)
+    giveBack(cache);
+} // end deallocate
+
+std::size_t NodeDepot::getSlabCount() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return slabs_.size();
+} // end getSlabCount
+
+std::size_t NodeDepot::getBlockSize() const
+{
+  return block_size_;
+} // end getBlockSize
+
+void NodeDepot::refill(Cache &cache)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!batches_.empty())
+  {
+    cache.free_list = batches_.back().first;
+    cache.free_count = batches_.back().count;
+    batches_.pop_back();
+    return;
+  }
+  unsigned char *slab = static_cast<unsigned char *>(::operator new(block_size_ * nodes_per_slab_));
+  slabs_.push_back(slab);
+  cache.bump = slab;
+  cache.bump_end = slab + block_size_ * nodes_per_slab_;
+} // end refill
+
+void NodeDepot::giveBack(Cache &cache)
+{
+  if (cache.free_count == 0)
+    return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  batches_.push_back(Batch{cache.free_list, cache.free_count});
+  cache.free_list = nullptr;
+  cache.free_count = 0;
+} // end giveBack
+
+void NodeDepot::giveBack(void *block)
+{
+  FreeBlock *freed = static_cast<FreeBlock *>(block);
+  freed->next = nullptr;
+  std::lock_guard<std::mutex> lock(mutex_);
+  batches_.push_back(Batch{freed, 1});
+} // end giveBack
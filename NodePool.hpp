@@ -0,0 +1,129 @@
+/** Slab storage for tree nodes.
+ NodeDepot hands out fixed-size blocks carved from large slabs, so building
+ a tree of n nodes costs about n / nodes_per_slab calls to operator new
+ instead of n. There is one depot per block size for the whole process.
+ Each thread allocates from and frees to a cache of its own, with no lock
+ and no atomic operation; the depot's mutex is only taken when a cache runs
+ dry (a new slab, or a batch of blocks freed on other threads) or holds too
+ many freed blocks and gives a batch back.
+ NodePoolAllocator adapts a depot to the Allocator interface so it can be
+ passed to std::allocate_shared; the node and its shared_ptr control block
+ then live in one block. The allocator has no state, so the control block
+ stores nothing for it.
+ @file NodePool.hpp */
+
+#ifndef NODE_POOL_
+#define NODE_POOL_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+class NodeDepot
+{
+public:
+  /** @param bytes the size of the objects to store
+      @return the depot for blocks of that size, made on first use; depots
+              are never destroyed, since nodes may be released at any time **/
+  static NodeDepot &forSize(std::size_t bytes);
+
+  NodeDepot(const NodeDepot &) = delete;
+  NodeDepot &operator=(const NodeDepot &) = delete;
+
+  /** @return a block of getBlockSize() bytes, aligned for any scalar type,
+              from the calling thread's cache **/
+  void *allocate();
+
+  /** @param block a block returned by allocate, on any thread
+      @post the block is put on the calling thread's cache **/
+  void deallocate(void *block);
+
+  /** @return the number of slabs requested from operator new so far **/
+  std::size_t getSlabCount() const;
+
+  std::size_t getBlockSize() const;
+
+private:
+  struct FreeBlock
+  {
+    FreeBlock *next;
+  };
+
+  struct Batch // blocks freed on one thread, handed to the depot together
+  {
+    FreeBlock *first;
+    std::size_t count;
+  };
+
+  struct Cache; // one per thread and depot, see NodePool.cpp
+  friend struct ThreadCaches;
+
+  NodeDepot(std::size_t block_size, std::size_t index);
+
+  std::size_t block_size_;
+  std::size_t nodes_per_slab_;
+  std::size_t index_;                  // this depot's cache in every thread's list
+
+  mutable std::mutex mutex_;           // guards everything below
+  std::vector<unsigned char *> slabs_; // never released; blocks may be cached on any thread
+  std::vector<Batch> batches_;         // freed blocks given back by thread caches
+
+  /** @param cache the calling thread's cache, out of blocks
+      @post cache holds a batch of freed blocks or a new slab to carve **/
+  void refill(Cache &cache);
+
+  /** @param cache a thread's cache
+      @post its freed blocks are the depot's **/
+  void giveBack(Cache &cache);
+
+  /** called when the calling thread's caches are gone (thread exit)
+      @post block is the depot's **/
+  void giveBack(void *block);
+};
+
+/** Allocator for std::allocate_shared that draws from the NodeDepot for the
+    size of U. All copies are equal, and nodes may outlive the tree that
+    made them or be released on another thread. **/
+template <class U>
+class NodePoolAllocator
+{
+public:
+  typedef U value_type;
+
+  NodePoolAllocator() {}
+
+  template <class V>
+  NodePoolAllocator(const NodePoolAllocator<V> &) {}
+
+  U *allocate(std::size_t n)
+  {
+    if (n != 1)
+      return static_cast<U *>(::operator new(n * sizeof(U)));
+    return static_cast<U *>(getDepot().allocate());
+  }
+
+  void deallocate(U *block, std::size_t n)
+  {
+    if (n != 1)
+      ::operator delete(block);
+    else
+      getDepot().deallocate(block);
+  }
+
+  /** @return the depot every allocator for U draws from **/
+  static NodeDepot &getDepot()
+  {
+    static NodeDepot &depot = NodeDepot::forSize(sizeof(U));
+    return depot;
+  }
+
+  template <class V>
+  bool operator==(const NodePoolAllocator<V> &) const { return true; }
+
+  template <class V>
+  bool operator!=(const NodePoolAllocator<V> &) const { return false; }
+};
+
+#endif
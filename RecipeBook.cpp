@@ -15,6 +15,13 @@
  */
 
 #include "RecipeBook.hpp"
+#include "FrozenRecipeBook.hpp"
+#include "MappedRecipeBook.hpp"
+#include "RecipeCsv.hpp"
+#include "TreeTraversal.hpp"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
  /**
     * Default constructor.
     * @post: Initializes name_ and description_ to empty strings,
@@ -33,20 +40,18 @@
     * @param description A brief description of the recipe.
     * @param mastered Indicates whether the recipe has been mastered (default is
     f alse).
-    * @post: Initializes the Recipe with the provided values.
+    * @post: Initializes the Recipe with the provided values. A RecipeText
+    passed in is shared, not copied.
     */
-    Recipe :: Recipe (const std::string & name,const int & difficulty_level,const std::string & description, const bool & mastered) {
-            name_ = name;
-            difficulty_level_=difficulty_level;
-            description_ = description;
-            mastered_ = mastered;
+    Recipe :: Recipe (RecipeText name, int difficulty_level, RecipeText description, bool mastered)
+        : name_(std::move(name)), difficulty_level_(difficulty_level), description_(std::move(description)), mastered_(mastered) {
     }
    /**
    * Equality operator.
    * @param other A const reference to another Recipe.
    * @return True if name_ is equal to other’s name_; false otherwise.
    */
-    bool Recipe :: operator== (const Recipe & other) {
+    bool Recipe :: operator== (const Recipe & other) const {
            return name_ == other.name_;
     }
     /**
@@ -55,7 +60,7 @@
     * @return True if name_ is lexicographically less than other's name_; false
     otherwise.
     */
-    bool Recipe :: operator< (const Recipe & other) {
+    bool Recipe :: operator< (const Recipe & other) const {
         return name_ < other.name_;
     }
 
@@ -66,14 +71,41 @@
   false otherwise.
   */
 
-    bool Recipe :: operator >(const Recipe & other) {
+    bool Recipe :: operator >(const Recipe & other) const {
         return name_ > other.name_;
     }
+    /**
+    * Name comparisons, so a lookup by name needs no Recipe (and no string copy).
+    * @param name The name to compare name_ against.
+    */
+    bool Recipe :: operator== (std::string_view name) const {
+        return name_ == name;
+    }
+    bool Recipe :: operator< (std::string_view name) const {
+        return name_ < name;
+    }
+    bool Recipe :: operator> (std::string_view name) const {
+        return name_ > name;
+    }
+    /**
+    * @param recipe The Recipe to add.
+    * @return: A change that adds recipe.
+    */
+    RecipeChange RecipeChange :: add (Recipe recipe){
+        return RecipeChange{ADD, std::move(recipe)};
+    }
+    /**
+    * @param name The name of the Recipe to remove.
+    * @return: A change that removes it.
+    */
+    RecipeChange RecipeChange :: remove (RecipeText name){
+        return RecipeChange{REMOVE, Recipe(std::move(name), 0, RecipeText(), false)};
+    }
   /**
   * Default Constructor.
   * @post: Initializes an empty RecipeBook.
   */
-  RecipeBook :: RecipeBook () : BinarySearchTree<Recipe> () { // Initalized with the constructor of BinaryTree Search
+  RecipeBook :: RecipeBook () : RecipeTree () { // Initalized with the constructor of BinaryTree Search
 
   }
   /**
@@ -87,76 +119,227 @@
   added to the RecipeBook.
   */
   RecipeBook :: RecipeBook (const std::string &filename){
-      std:: ifstream fin(filename);
-      if (fin.fail()) {
-      std::cerr << "File cannot be opened for reading." << std:: endl;
-      exit(1); // exit if failed to open the file
-        }
-      std::string junk;
-      std:: getline(fin,junk); //header
-      std::string start; // first line
-      std:: string names,difficulty_levels,descriptions,mastereds; // creates string of names
-      while(std::getline(fin,start)){ // get line
-          std:: istringstream line(start); //
-          std::getline(line,names,','); // gets names
-          std::getline(line,difficulty_levels,','); // gets levels
-          std::getline(line,descriptions,','); // get descriptions
-          std::getline (line,mastereds,','); // gets mastery level
-          
-          bool mastered = false;
-          if(mastereds == "0"){
-            mastered= false;
+      std::string error;
+      if(!loadCsv(filename, error)){ // reports instead of exiting
+          throw std::runtime_error(error);
+      }
+  }
+  /**
+  * Copy Constructor.
+  * @param other The RecipeBook to copy.
+  * @post: Holds copies of other's Recipes, indexed the same way.
+  */
+  RecipeBook :: RecipeBook (const RecipeBook & other) : RecipeTree(other), mastery_index_(other.mastery_index_), use_name_index_(other.use_name_index_){
+      rebuildNameIndex(); // the copied tree has its own nodes
+  }
+  /**
+  * Copy Assignment.
+  * @param other The RecipeBook to copy.
+  * @return: This RecipeBook, with its name index rebuilt if it uses one.
+  */
+  RecipeBook & RecipeBook :: operator= (const RecipeBook & other){
+      if(this != &other){
+          RecipeTree::operator=(other);
+          mastery_index_ = other.mastery_index_;
+          use_name_index_ = other.use_name_index_;
+          rebuildNameIndex();
+      }
+      return *this;
+  }
+  /**
+  * Move Constructor.
+  * @param other The RecipeBook to move from; it is left empty.
+  */
+  RecipeBook :: RecipeBook (RecipeBook && other) : RecipeTree(std::move(other)), mastery_index_(std::move(other.mastery_index_)),
+      use_name_index_(other.use_name_index_), name_index_(std::move(other.name_index_)), descriptions_(std::move(other.descriptions_)){
+  }
+  /**
+  * Move Assignment.
+  * @param other The RecipeBook to move from; it is left empty.
+  * @return: This RecipeBook, holding other's Recipes and indexes.
+  */
+  RecipeBook & RecipeBook :: operator= (RecipeBook && other){
+      if(this != &other){
+          RecipeTree::operator=(std::move(other));
+          mastery_index_ = std::move(other.mastery_index_); // leaves other's index empty, as its tree is
+          use_name_index_ = other.use_name_index_;
+          name_index_ = std::move(other.name_index_);
+          descriptions_ = std::move(other.descriptions_);
+      }
+      return *this;
+  }
+  /**
+  * Takes a snapshot of the book in O(1) by sharing its nodes.
+  * @return: A RecipeBook holding the same Recipes; neither book sees the
+  other's later changes.
+  */
+  RecipeBook RecipeBook :: snapshot (){
+      if(use_name_index_){ // the index points at nodes, which the books would replace separately
+          return RecipeBook(*this);
+      }
+      RecipeBook shared;
+      shared.shareFrom(*this); // both books copy a node before changing it from now on
+      shared.mastery_index_ = mastery_index_.snapshot(); // shared the same way
+      return shared;
+  }
+  /**
+  * Adds every Recipe of a CSV file (see RecipeCsv.hpp for the format).
+  * @param filename A const reference to the name of the CSV file.
+  * @param error Set to a message if the file cannot be read or parsed.
+  * @post: Recipes are added as by addRecipe, in file order, so the first of
+  several Recipes with the same name wins. Nothing is added on error.
+  * @return: True on success; false otherwise.
+  */
+  bool RecipeBook :: loadCsv (const std::string & filename, std::string & error){
+      std::vector<Recipe> batch; // parsed and sorted from the mapped file on one thread per core
+      if(!readRecipeCsvSorted(filename, batch, error)){
+          return false;
+      }
+      bulkLoad(std::move(batch)); // already sorted, with equal names in file order, so the first one wins
+      return true;
+  }
+  /**
+  * Adds a batch of Recipes in one O(n + m) pass.
+  * @param recipes The Recipes to add, in any order; they are sorted by name
+  unless already sorted, and moved into their nodes.
+  * @post: The result is the same as calling addRecipe on each Recipe in
+  order (Recipes already in the book and the first of several with the same
+  name win), and the tree is rebuilt perfectly balanced.
+  * @return: The number of Recipes added.
+  */
+  std::size_t RecipeBook :: bulkLoad (std::vector<Recipe> recipes){
+      auto by_name = [](const Recipe & a, const Recipe & b) { return a < b; };
+      if(!std::is_sorted(recipes.begin(), recipes.end(), by_name)){ // exports usually come sorted already
+          std::stable_sort(recipes.begin(), recipes.end(), by_name); // stable, so the first of equal names stays first
+      }
+      recipes.erase(std::unique(recipes.begin(), recipes.end(),
+                                [](const Recipe & a, const Recipe & b) { return a == b; }), recipes.end());
+      std::size_t added_count = mergeSorted(recipes.begin(), recipes.end(), [this](const std::shared_ptr<BinaryNode<Recipe>> & added) {
+          internDescription(added); // repeated descriptions end up sharing one block; rejected ones never reach the pool
+          if(!added->getItem().mastered_){ // unmastered recipes count toward mastery points
+              mastery_index_.add(added->getItem().difficulty_level_);
           }
-          else {
-            mastered = true;
+      });
+      rebuildNameIndex(); // new nodes, in one pass
+      return added_count;
+  }
+  /**
+  * Adds every Recipe of a staging list in one O(n + m) pass.
+  * @param staged Recipes added by any number of threads, already sorted and unique by name.
+  * @return: The number of Recipes added.
+  */
+  std::size_t RecipeBook :: bulkLoad (RecipeStagingList & staged){
+      return bulkLoad(staged.takeAll()); // comes out sorted, so nothing is sorted again
+  }
+  /**
+  * Applies a batch of adds and removes.
+  * @param changes The changes, in the order they were made.
+  * @post: The book is the same as after calling addRecipe or removeRecipe
+  for each change in order.
+  * @return: For each change in order, what that call would have returned.
+  * @note: Below m = n changes they are applied as descents in name order;
+  from there on, merged in one O(n + m) rebuild (see RecipeBook.hpp).
+  */
+  std::vector<bool> RecipeBook :: applyBatch (std::vector<RecipeChange> changes){
+      std::vector<bool> results(changes.size());
+      std::vector<std::size_t> order(changes.size());
+      std::iota(order.begin(), order.end(), 0);
+      std::stable_sort(order.begin(), order.end(), [&changes](std::size_t a, std::size_t b) { // stable, so each name's changes stay in order
+          return changes[a].recipe_ < changes[b].recipe_;
+      });
+      if(changes.size() < static_cast<std::size_t>(getNumberOfNodes())){ // the threshold: m descents in name order cost less than reading all n names
+          for(std::size_t i : order){
+              RecipeChange & change = changes[i];
+              results[i] = change.kind_ == RecipeChange::ADD ? addRecipe(change.recipe_) : removeRecipe(change.recipe_.name_);
+          }
+          return results;
+      }
+      // Look every name up first, side by side (see findBatch); that reads
+      // far fewer names than walking the whole book would
+      std::vector<std::string_view> names; // each name once, in order
+      for(std::size_t i : order){
+          if(names.empty() || names.back() != std::string_view(changes[i].recipe_.name_)){
+              names.push_back(changes[i].recipe_.name_);
           }
-          
-        //std::cout << names << " "; testing 
-        //std:: cout << difficulty_levels<< " ";
-        //std:: cout << descriptions << " " ;
-        //std:: cout << mastered << " ";
-        //std :: cout << std:: endl;
-        Recipe recipe = {names,stoi(difficulty_levels),descriptions,mastered};
-        addRecipe(recipe);
-        //std: cout << addRecipe(recipe) << std::endl; check if add works
+      }
+      std::vector<const Recipe *> found(names.size());
+      findBatch(names.begin(), names.end(), found.begin());
 
+      // Settle each name, replaying its changes in order
+      std::vector<Recipe> puts; // names whose last successful change added a Recipe
+      std::vector<std::string_view> erases; // names in the book whose last successful change removed it
+      for(std::size_t first = 0, k = 0; first < order.size(); k++){
+          std::string_view name = names[k];
+          std::size_t last = first + 1;
+          while(last < order.size() && changes[order[last]].recipe_.name_ == name){
+              last++;
+          }
+          bool existed = found[k] != nullptr;
+          bool present = existed;
+          Recipe * added = nullptr; // the Recipe the name ends up holding, if a change added it
+          for(std::size_t j = first; j < last; j++){
+              RecipeChange & change = changes[order[j]];
+              bool succeeded = change.kind_ == RecipeChange::ADD ? !present : present; // as addRecipe and removeRecipe decide
+              results[order[j]] = succeeded;
+              if(succeeded){
+                  present = change.kind_ == RecipeChange::ADD;
+                  added = present ? &change.recipe_ : nullptr;
+              }
+          }
+          if(added){ // replaces the Recipe in the book, if one was removed first
+              puts.push_back(std::move(*added));
+          }
+          else if(existed && !present){
+              erases.push_back(name); // views a name in changes, which moving other names leaves alone
+          }
+          first = last;
       }
-  }    
-  /**
-    * Helper Function to find the pointer 
-    * @param name A const reference to the smart pointer containg a node
-    * @param recipe A Recipe struct of a recipe
-    * @return A pointer to the node containing the Recipe with the given
-    difficulty level, or nullptr if not found.
-    */ 
-  std::shared_ptr<BinaryNode<Recipe>> RecipeBook :: findRecipehelper(const std::shared_ptr<BinaryNode<Recipe>>& node,  Recipe  recipe)const {
-      if(node == nullptr){ // if not found
-        return nullptr;
+      for(Recipe & recipe : puts){
+          recipe.description_ = descriptions_.intern(recipe.description_);
+          if(!recipe.mastered_){ // unmastered recipes count toward mastery points
+              mastery_index_.add(recipe.difficulty_level_);
+          }
       }
-    if( node ->getItem().name_ == recipe.name_){ // if the node is holding the same name, returns the recipe as a pointer
-      return node;
-    }
-    if(node ->getItem().name_ > recipe.name_){ // if it is node > given recipe, checks left side
-        return(findRecipehelper(node->getLeftChildPtr(),recipe)); // checks left side til finds the pointer 
-    }
-    
-      return(findRecipehelper(node->getRightChildPtr(),recipe)); // checks right til it finds the pointer 
-    
+      mergeEdits(puts.begin(), puts.end(), erases.begin(), erases.end(), [this](const Recipe & removed) {
+          if(!removed.mastered_){
+              mastery_index_.remove(removed.difficulty_level_); // no longer counted
+          }
+      });
+      rebuildNameIndex(); // new and relinked nodes, in one pass
+      return results;
   }
-  
-
   /**
-  * Finds a Recipe in the tree by name.
+  * Finds a Recipe in the tree by name, without building a Recipe.
   * @param name A const reference to the name.
   * @return A pointer to the node containing the Recipe with the given
   name , or nullptr if not found.
   */
   std::shared_ptr<BinaryNode<Recipe>> RecipeBook ::  findRecipe (const std::string & name) const{
-      Recipe top; // recipe 
-      top.name_ = name; // with name
-    return(findRecipehelper(getRoot(),top)); //calls helperfucntion
+    if(use_name_index_){ // B+ tree by name, a few nodes per lookup
+        const std::shared_ptr<BinaryNode<Recipe>> * found = name_index_.find(std::string_view(name));
+        return found ? *found : nullptr;
+    }
+    return find(std::string_view(name)); // searches by the name key, no Recipe needed
     
   }
+  /**
+  * Finds many Recipes by name at once.
+  * @param names The names to look up, in any order, repeats allowed.
+  * @return: For each name in order, the Recipe with that name, or nullptr
+  if not found.
+  */
+  std::vector<const Recipe *> RecipeBook :: findMany (const std::vector<std::string_view> & names) const{
+    std::vector<const Recipe *> found(names.size());
+    if(use_name_index_){ // the B+ tree already reads a few packed nodes per name
+        for(std::size_t i = 0; i < names.size(); i++){
+            const std::shared_ptr<BinaryNode<Recipe>> * indexed = name_index_.find(names[i]);
+            found[i] = indexed ? &(*indexed)->getItem() : nullptr;
+        }
+        return found;
+    }
+    findBatch(names.begin(), names.end(), found.begin()); // descends for 16 names side by side
+    return found;
+  }
 
 
   
@@ -171,34 +354,105 @@
   the same name already exists.
   */
   bool RecipeBook :: addRecipe (const Recipe & recipe){
-      if(contains(recipe)){ // contains check if it exist, it does, returns false;
+      std::pair<std::shared_ptr<BinaryNode<Recipe>>, bool> inserted = tryInsert(recipe);
+      if(!inserted.second){ // checks and adds in one walk down the tree, copies only if added
           return false;
       }
-      add(recipe);// adds using the bst add function
-      return true;// will always return true
-      
+      internDescription(inserted.first); // only now, so duplicates leave the pool alone
+      if(use_name_index_){
+          name_index_.add(inserted.first);
+      }
+      if(!recipe.mastered_){ // unmastered recipes count toward mastery points
+          mastery_index_.add(recipe.difficulty_level_);
+      }
+      return true;
+  }
+  /**
+  * Builds a Recipe from its fields directly inside a new tree node.
+  * @param name The name of the recipe.
+  * @param difficulty_level The difficulty level of the recipe.
+  * @param description A brief description of the recipe.
+  * @param mastered Indicates whether the recipe has been mastered.
+  * @post: Same as addRecipe, with each string copied once, straight into
+  the node's text.
+  * @return: True if the Recipe was added; false if a Recipe with the same
+  name already exists.
+  */
+  bool RecipeBook :: emplaceRecipe (std::string_view name, int difficulty_level, std::string_view description, bool mastered){
+      std::pair<std::shared_ptr<BinaryNode<Recipe>>, bool> inserted = emplace(RecipeText(name), difficulty_level, RecipeText(description), mastered);
+      if(!inserted.second){
+          return false;
+      }
+      internDescription(inserted.first);
+      if(use_name_index_){
+          name_index_.add(inserted.first);
+      }
+      if(!mastered){ // unmastered recipes count toward mastery points
+          mastery_index_.add(difficulty_level);
+      }
+      return true;
   }
   /**
   * Removes a Recipe from the tree by name.
-  * @param name A const reference to a string representing the name of the
-  Recipe.
+  * @param name The name of the Recipe, viewed without a copy.
   * @post: If found, the Recipe is removed from the tree.
   * @return: True if the Recipe was successfully removed{ false otherwise.
   */
-  bool RecipeBook :: removeRecipe (const std::string & name){
-      Recipe recipe;
-      recipe.name_= name; // sets the recipe with this name
-      if(remove(recipe)){ // if removes is true;
+  bool RecipeBook :: removeRecipe (std::string_view name){
+      std::shared_ptr<BinaryNode<Recipe>> removed = extract(name); // removes by the name key
+      if(removed){ // if removes is true;
+          if(use_name_index_){
+              name_index_.erase(name);
+          }
+          if(!removed->getItem().mastered_){
+              mastery_index_.remove(removed->getItem().difficulty_level_); // no longer counted
+          }
           return true; // return true;
       }
       return false; // returns false;
   }
   /**
+  * Marks a Recipe as mastered or not mastered.
+  * @param name A const reference to the name of the Recipe.
+  * @param mastered The new value of mastered_.
+  * @post: The Recipe and the mastery index are updated.
+  * @return: True if the Recipe was found; false otherwise.
+  */
+  bool RecipeBook :: setMastered (const std::string & name, bool mastered){
+      std::shared_ptr<BinaryNode<Recipe>> node = findForUpdate(std::string_view(name)); // copies the node first if a snapshot holds it
+      if(!node){
+          return false;
+      }
+      if(use_name_index_){ // the index must point at the copy, not at the snapshot's node
+          const std::shared_ptr<BinaryNode<Recipe>> * indexed = name_index_.find(std::string_view(name));
+          if(!indexed || *indexed != node){
+              name_index_.erase(std::string_view(name));
+              name_index_.add(node);
+          }
+      }
+      if(node->getItem().mastered_ == mastered){ // nothing changes
+          return true;
+      }
+      Recipe updated = node->getItem();
+      updated.mastered_ = mastered;
+      if(mastered){
+          mastery_index_.remove(updated.difficulty_level_);
+      }
+      else {
+          mastery_index_.add(updated.difficulty_level_);
+      }
+      node->setItem(std::move(updated));
+      return true;
+  }
+  /**
   * Clears all Recipes from the tree.
-  * @post: The tree is emptied, and all nodes are deallocated.
+  * @post: The tree is emptied, and the nodes no snapshot holds are freed.
   */
   void RecipeBook :: clear (){
-      setRoot(nullptr);
+      RecipeTree::clear(); // visits every node it frees; their blocks are reused by later adds
+      mastery_index_.clear();
+      name_index_.clear();
+      descriptions_.clear(); // Recipes held elsewhere keep their own references
   }
      /**
     * helps calculates the number of mastery points needed to master a Recipe.
@@ -211,16 +465,10 @@
     */
 
   int  RecipeBook :: caclulateMasteryHelper (const std::shared_ptr<BinaryNode<Recipe>>& node, int difficulty) const { // pre order transveral
-      int points = 0;
-        if(node == nullptr){  // check if the node == nullptr
-          return 0;
-        }
-        if(!node ->getItem().mastered_ && node ->getItem().difficulty_level_ <= difficulty){ // if recpie is not mastered, and the diffculity level < the difficulty
-            points++;
-        }
-        points +=caclulateMasteryHelper(node ->getLeftChildPtr(),difficulty); // left side
-        points +=caclulateMasteryHelper(node -> getRightChildPtr(),difficulty); // right side
-        return points; // return the points
+      // large subtrees are counted on several threads (see BinarySearchTree::countIf)
+      return countIf(node, [difficulty](const Recipe & recipe){
+          return !recipe.mastered_ && recipe.difficulty_level_ <= difficulty; // if recpie is not mastered, and the diffculity level < the difficulty
+      });
 
   }
     /**
@@ -233,17 +481,44 @@
     -1 if the Recipe is not found. If the recipe is already mastered, return 0.
     * Note: Mastery points are calculated as the number of unmastered Recipes in
     the tree with a lower difficulty level than the given Recipe. Add one if the
-    Recipe is not mastered.
+    Recipe is not mastered. The count comes from the mastery index in O(log n).
     */
     int RecipeBook :: calculateMasteryPoints (const std::string & name ) const{
-        if(!findRecipe(name)){ // if cant find returns -1
+        const Recipe * found = nullptr; // looked up once, without touching reference counts
+        if(use_name_index_){
+            const std::shared_ptr<BinaryNode<Recipe>> * indexed = name_index_.find(std::string_view(name));
+            found = indexed ? &(*indexed)->getItem() : nullptr;
+        }
+        else {
+            found = findItem(std::string_view(name));
+        }
+        if(!found){ // if cant find returns -1
           return -1;  
       }
       
-      if(findRecipe(name) ->getItem().mastered_ == true){ // if mastered ==  true;, returns 0
+      if(found ->mastered_ == true){ // if mastered ==  true;, returns 0
           return 0;
         }
-        return caclulateMasteryHelper(getRoot(),findRecipe(name)->getItem().difficulty_level_); // returns how many if condtions are met
+        return mastery_index_.countAtMost(found->difficulty_level_); // unmastered recipes at or below, in O(log n)
+    }
+    /**
+    * Rebuilds the mastery index from the Recipes in the tree.
+    * @post: The index counts every unmastered Recipe by difficulty level.
+    */
+    void RecipeBook :: rebuildMasteryIndex (){
+        mastery_index_.clear();
+        indexMasteryHelper(getRoot());
+    }
+    /**
+    * Counts every unmastered Recipe of a subtree in the mastery index.
+    * @param node A const reference to the root of the subtree.
+    */
+    void RecipeBook :: indexMasteryHelper (const std::shared_ptr<BinaryNode<Recipe>>& node){
+        preorderTraverse(node, [this](const std::shared_ptr<BinaryNode<Recipe>>& visited){
+            if(!visited->getItem().mastered_){
+                mastery_index_.add(visited->getItem().difficulty_level_);
+            }
+        });
     }
 
     /**
@@ -253,14 +528,10 @@
     * @post: Tree vector contains the Recipes inorder transveral form
     */
 
-    void RecipeBook :: inorderhelp ( std::shared_ptr<BinaryNode<Recipe>> node, std::vector<Recipe> & tree){
-        if(node == nullptr){ // if node == nothing, nothing wil happen
-            return;
-        }
-
-        inorderhelp(node->getLeftChildPtr(),tree); // get the left side right
-        tree.push_back(node->getItem());  // puts into vector
-        inorderhelp(node ->getRightChildPtr(),tree); // get right
+    void RecipeBook :: inorderhelp (const std::shared_ptr<BinaryNode<Recipe>>& node, std::vector<Recipe> & tree){
+        inorderTraverse(node, [&tree](const std::shared_ptr<BinaryNode<Recipe>>& visited){ // left side, node, right side
+            tree.push_back(visited->getItem());  // puts into vector
+        });
 
     }
     /**
@@ -277,49 +548,111 @@
         }
         int med; // to keep the root
         med = (start+ends)/2; // will be the root
-      Recipe recipe(tree[med].name_, tree[med].difficulty_level_, tree[med].description_, tree[med].mastered_); // helper to set the root with the item in the middle
-        std::shared_ptr<BinaryNode<Recipe>> top = std::make_shared<BinaryNode<Recipe>>(recipe);
+        std::shared_ptr<BinaryNode<Recipe>> top = makeNode(tree[med]); // from the book's node pool, with the item in the middle
         top ->setLeftChildPtr(buildtreehelp(tree,start, med-1)); // builds the left side
         top -> setRightChildPtr(buildtreehelp(tree,med+1,ends)); // builds the right side
+        AvlPolicy::updateHeight(top); // keeps the stored heights and sizes right for later adds and removes
         return top; // returns root
     }
    /**
     * Balances the tree.
     * @post: The tree is balanced such that for any node, the heights of its
     left and right subtrees differ by no more than 1.
-    * @note: You may implement this by performing an inorder traversal to get
-    sorted Recipes and rebuilding the tree.
+    * @note: The existing nodes are relinked in place (see
+    BinarySearchTree::balanceInPlace), so no Recipe is copied and nothing is
+    allocated.
     */
     void RecipeBook :: balance (){
-        std::vector<Recipe> tree; // vector for the tree
-
-        inorderhelp(getRoot(),tree); // in order transveral 
-
-      setRoot(buildtreehelp(tree,0,tree.size()-1)); // calls to build the tree and sets the root with the new root
-      
+        balanceInPlace(); // relinks the nodes, no copies of the recipes
+    }
+    /**
+    * Compiles the book into a read-only copy laid out for fast lookups.
+    * @return: A FrozenRecipeBook holding a copy of every Recipe.
+    */
+    FrozenRecipeBook RecipeBook :: freeze () const{
+        return FrozenRecipeBook(*this); // copies the recipes in order, then lays out the keys
+    }
+    /**
+    * Saves the book in the compact binary format of MappedRecipeBook.hpp.
+    * @param filename A const reference to the name of the file to write.
+    * @param error Set to a message if the file cannot be written.
+    * @return: True on success; false otherwise.
+    */
+    bool RecipeBook :: save (const std::string & filename, std::string & error) const{
+        return MappedRecipeBook::save(*this, filename, error); // string pool and records, in name order
+    }
+    /**
+    * Opens a file written by save without parsing it.
+    * @param filename A const reference to the name of the file.
+    * @param book Set to a read-only book over the memory-mapped file.
+    * @param error Set to a message if the file cannot be opened or is damaged.
+    * @return: True on success; false otherwise.
+    */
+    bool RecipeBook :: openMapped (const std::string & filename, MappedRecipeBook & book, std::string & error){
+        return book.open(filename, error); // checks the header and checksum; no Recipe is parsed or copied
+    }
+    /**
+    * Chooses whether lookups go through a B+ tree of the nodes by name.
+    * @param enabled True to build the name index and keep it up to date;
+    false to drop it and search the binary tree again.
+    */
+    void RecipeBook :: useNameIndex (bool enabled){
+        use_name_index_ = enabled;
+        if(enabled){ // nodes shared with a snapshot are copied first, so the index never points at them
+            ownAllNodes();
+        }
+        rebuildNameIndex(); // builds it, or empties it when disabled
+    }
+    /**
+    * @return: True if lookups go through the name index.
+    */
+    bool RecipeBook :: usesNameIndex () const{
+        return use_name_index_;
+    }
+    /**
+    * Rebuilds the name index from the nodes of the tree, if the book uses one.
+    */
+    void RecipeBook :: rebuildNameIndex (){
+        name_index_.clear();
+        if(!use_name_index_){
+            return;
+        }
+        inorderTraverse(getRoot(), [this](const std::shared_ptr<BinaryNode<Recipe>>& node){ // nodes in name order
+            name_index_.add(node);
+        });
+    }
+    /**
+    * Interns the description of a Recipe that was just added.
+    * @param node A const reference to the new node, owned by this book.
+    */
+    void RecipeBook :: internDescription (const std::shared_ptr<BinaryNode<Recipe>>& node){
+        RecipeText pooled = descriptions_.intern(node->getItem().description_);
+        if(!pooled.isShared() || pooled.data() == node->getItem().description_.data()){ // inline, or already the pool's block
+            return;
+        }
+        Recipe updated = node->getItem(); // shares the strings, nothing is copied
+        updated.description_ = std::move(pooled);
+        node->setItem(std::move(updated));
     }
      /**
     * Helper Fucntion that helps Displays the tree in preorder traversal 
     *@param node a smart pointer that contains the node
     * @post: Outputs the Recipes in the tree in preorder, formatted as:
     */
-    void  RecipeBook ::preorderDisplayhelp ( std::shared_ptr<BinaryNode<Recipe>>  node ) const {
+    void  RecipeBook ::preorderDisplayhelp (const std::shared_ptr<BinaryNode<Recipe>>&  node ) const {
     
-          if(node == nullptr){ // if node is null, nothing happens
-            return;
-          }
-          std::cout << "Name: " <<node -> getItem().name_ <<std::endl; // prints out name
-          std::cout << "Difficulty Level: " <<node -> getItem().difficulty_level_ <<std::endl; // prints out difficulty level
-          std::cout << "Description: " << node ->getItem().description_ << std::endl; // prints out description
-          if(node->getItem().mastered_){ // mastered
-              std::cout << "Mastered: " << "Yes" << std::endl; // prints yes if true
-          } 
-          else {
-              std::cout << "Mastered: " << "No" << std::endl; // prints no if not true
-          }
-          std:: cout << std::endl;
-          preorderDisplayhelp(node ->getLeftChildPtr()); // left side
-          preorderDisplayhelp(node -> getRightChildPtr()); // right side
+          preorderTraverse(node, [](const std::shared_ptr<BinaryNode<Recipe>>& visited){ // node, then left side, then right side
+              std::cout << "Name: " <<visited -> getItem().name_ <<std::endl; // prints out name
+              std::cout << "Difficulty Level: " <<visited -> getItem().difficulty_level_ <<std::endl; // prints out difficulty level
+              std::cout << "Description: " << visited ->getItem().description_ << std::endl; // prints out description
+              if(visited->getItem().mastered_){ // mastered
+                  std::cout << "Mastered: " << "Yes" << std::endl; // prints yes if true
+              } 
+              else {
+                  std::cout << "Mastered: " << "No" << std::endl; // prints no if not true
+              }
+              std:: cout << std::endl;
+          });
            
     }
 
@@ -2,7 +2,7 @@
 /**
  * @file RecipeBook.hpp
  * @brief This file contains the declaration of the RecipeBook class, which represents a virtual recipe book that allows chefs to easily get the recipes and a Recipe Struct that represents Recipe
- *  There are no arritbutes in the RecipeBook Class. There are 4 arritbutes of the Recipe class such as name,difficulty level, description, mastered.
+ *  The RecipeBook Class keeps one arritbute, an index of unmastered recipes by difficulty used for mastery points. There are 4 arritbutes of the Recipe class such as name,difficulty level, description, mastered.
  * RecipeBook provides constructors, accessor and mutator functions, that allows the user to move around recipes in the RecipeBook, know what they need to master, and display the 
  * recipes.
  * Recipe provdies constructor and operators in order to adjust the recipe, and to compare recipes based off names
@@ -18,8 +18,15 @@
 #include <fstream>
 #include <sstream>
 #include <string> 
+#include <string_view>
 #include <vector>
 #include "BinaryNode.hpp"
+#include "MasteryIndex.hpp"
+#include "BPlusTree.hpp"
+#include "ConcurrentSkipList.hpp"
+#include "RecipeText.hpp"
+class FrozenRecipeBook; // see FrozenRecipeBook.hpp
+class MappedRecipeBook; // see MappedRecipeBook.hpp
 struct Recipe {
     public :
     /**
@@ -35,41 +42,110 @@ struct Recipe {
     * @param description A brief description of the recipe.
     * @param mastered Indicates whether the recipe has been mastered (default is
     f alse).
-    * @post: Initializes the Recipe with the provided values.
+    * @post: Initializes the Recipe with the provided values. A string_view,
+    std::string or RecipeText converts to RecipeText; passing a RecipeText
+    shares its characters instead of copying them.
     */
-    Recipe (const std::string & name,const int & difficulty_level,const std::string & description, const bool & mastered);
+    Recipe (RecipeText name, int difficulty_level, RecipeText description, bool mastered);
    /**
     * Equality operator.
     * @param other A const reference to another Recipe.
     * @return True if name_ is equal to other's name_;
     false otherwise.
     */
-    bool operator== (const Recipe & other);
+    bool operator== (const Recipe & other) const;
     /**
     * Less-than operator.
     * @param other A const reference to another Recipe.
-    * @return True if difficulty_level_ is less than other's difficulty_level_;
+    * @return True if name_ is lexicographically less than other's name_;
     false otherwise.
     */
 
-     bool operator< (const Recipe & other);
+     bool operator< (const Recipe & other) const;
 
      /**
     * Greater-than operator.
     * @param other A const reference to another Recipe.
-    * @return True if difficulty_level_ is greater than other's
-    difficulty_level_; false otherwise.
+    * @return True if name_ is lexicographically greater than other's
+    name_; false otherwise.
     */
 
-     bool operator >(const Recipe & other);
+     bool operator >(const Recipe & other) const;
+
+    /**
+    * Name comparisons, so a lookup by name needs no Recipe (and no string copy).
+    * @param name The name to compare name_ against.
+    */
+    bool operator== (std::string_view name) const;
+    bool operator< (std::string_view name) const;
+    bool operator> (std::string_view name) const;
 
 
-    std::string name_; //The name of the recipe.
+    RecipeText name_; //The name of the recipe. Short names are stored inline.
     int difficulty_level_; //An integer representing the difficulty level of the recipe (1-10).
-    std::string description_; //A brief description of the recipe
+    RecipeText description_; //A brief description of the recipe, shared by every copy and, in a book, by equal descriptions
     bool mastered_; //Indicates whether the recipe has been mastered by the kitchen staff.
 };
-class RecipeBook : public BinarySearchTree<Recipe>{
+/**
+ * One change of a batch handed to RecipeBook::applyBatch.
+ */
+struct RecipeChange {
+    enum Kind { ADD, REMOVE };
+    /**
+    * @param recipe The Recipe to add.
+    * @return: A change that adds recipe, as addRecipe would.
+    */
+    static RecipeChange add (Recipe recipe);
+    /**
+    * @param name The name of the Recipe to remove.
+    * @return: A change that removes it, as removeRecipe would.
+    */
+    static RecipeChange remove (RecipeText name);
+
+    Kind kind_; //Whether the change adds or removes a Recipe.
+    Recipe recipe_; //The Recipe to add; a removal only reads its name_.
+};
+/**
+ * Orders Recipes by name_, so the tree can be searched with a plain
+ * std::string_view name.
+ */
+struct RecipeNameKey {
+    static std::string_view key (const Recipe & recipe) { return recipe.name_; }
+};
+/**
+ * Key policy for an index of tree nodes: a node is keyed by its Recipe's name.
+ */
+struct RecipeNodeNameKey {
+    static std::string_view key (const std::shared_ptr<BinaryNode<Recipe>> & node) { return node->getItem().name_; }
+};
+/**
+ * Name index over the nodes of a RecipeBook, searched with SIMD prefix
+ * compares (see BPlusTree.hpp).
+ */
+typedef BPlusTree<std::shared_ptr<BinaryNode<Recipe>>, RecipeNodeNameKey> RecipeNameIndex;
+/**
+ * Lock-free staging area where several threads can add parsed Recipes at
+ * once, rejecting duplicate names like addRecipe (see ConcurrentSkipList.hpp).
+ * Hand it to RecipeBook::bulkLoad once the threads are done.
+ */
+typedef ConcurrentSkipList<Recipe, RecipeNameKey> RecipeStagingList;
+/**
+ * Recipes are kept in an AVL-balanced tree so that books loaded from sorted
+ * exports stay O(log n) deep without calling balance() by hand. Nodes are
+ * carved out of slabs by NodePoolAllocator instead of one heap allocation each.
+ * Descriptions added to a book are interned (see RecipeText.hpp): Recipes with
+ * the same long description share one copy of it, and copying a Recipe out of
+ * the tree never allocates.
+ * The mastery index is kept up to date by RecipeBook's own methods only; after
+ * changing the tree through the inherited BinarySearchTree methods (or by
+ * editing a node returned by findRecipe), call rebuildMasteryIndex().
+ * A book can also keep its nodes in a B+ tree by name (see useNameIndex);
+ * findRecipe then searches that instead of the binary tree. The same rule
+ * applies: call rebuildNameIndex() after changing the tree directly.
+ */
+typedef BinarySearchTree<Recipe, AvlPolicy, NodePoolAllocator<BinaryNode<Recipe>>, RecipeNameKey> RecipeTree;
+
+class RecipeBook : public RecipeTree{
 
 public:
     /**
@@ -85,25 +161,105 @@ public:
     * The file format is as follows:
     * name,difficulty_level,description,mastered
     * Ignore the first line. Each subsequent line represents a Recipe to be
-    added to the RecipeBook.
+    added to the RecipeBook (see parseRecipeCsv in RecipeCsv.hpp for how the
+    fields are read).
+    * @throws std::runtime_error if the file cannot be read or a line is malformed.
     */
     RecipeBook (const std::string &filename);
     /**
-    * Helper Function to find the pointer 
-    * @param name A const reference to the smart pointer containg a node
-    * @param recipe A Recipe struct of a recipe
-    * @return A pointer to the node containing the Recipe with the given
-    difficulty level, or nullptr if not found.
+    * Copy Constructor.
+    * @param other The RecipeBook to copy.
+    * @post: Holds copies of other's Recipes, indexed the same way.
     */
-
-    std::shared_ptr<BinaryNode<Recipe>> findRecipehelper(const std::shared_ptr<BinaryNode<Recipe>>& node,  Recipe  recipe)const;
+    RecipeBook (const RecipeBook & other);
+    /**
+    * Copy Assignment.
+    * @param other The RecipeBook to copy.
+    * @return: This RecipeBook, with its name index rebuilt if it uses one.
+    */
+    RecipeBook & operator= (const RecipeBook & other);
+    /**
+    * Move Constructor.
+    * @param other The RecipeBook to move from; it is left empty.
+    */
+    RecipeBook (RecipeBook && other);
+    /**
+    * Move Assignment.
+    * @param other The RecipeBook to move from; it is left empty.
+    * @return: This RecipeBook, holding other's Recipes and indexes.
+    */
+    RecipeBook & operator= (RecipeBook && other);
+    /**
+    * Takes a snapshot of the book, e.g. for a report.
+    * @return: A RecipeBook holding the same Recipes, made in O(1): the two
+    books share their nodes, and each copies the few nodes a change touches
+    instead of changing them, so neither sees the other's later changes.
+    Only a book that uses a name index is copied in O(n), since its index
+    points at nodes; the snapshot then keeps the index too.
+    */
+    RecipeBook snapshot ();
+    /**
+    * Adds every Recipe of a CSV file (see RecipeCsv.hpp for the format).
+    * @param filename A const reference to the name of the CSV file.
+    * @param error Set to a message if the file cannot be read or parsed.
+    * @post: Recipes are added as by addRecipe, in file order, so the first of
+    several Recipes with the same name wins. Nothing is added on error.
+    * @return: True on success; false otherwise.
+    */
+    bool loadCsv (const std::string & filename, std::string & error);
+    /**
+    * Adds a batch of Recipes in one O(n + m) pass.
+    * @param recipes The Recipes to add, in any order; they are sorted by name
+    unless already sorted, and moved into their nodes.
+    * @post: The result is the same as calling addRecipe on each Recipe in
+    order (Recipes already in the book and the first of several with the same
+    name win), and the tree is rebuilt perfectly balanced.
+    * @return: The number of Recipes added.
+    */
+    std::size_t bulkLoad (std::vector<Recipe> recipes);
     /**
-    * Finds a Recipe in the tree by name.
+    * Adds every Recipe of a staging list in one O(n + m) pass.
+    * @param staged Recipes added by any number of threads, already sorted
+    and unique by name; no other thread may use it during the call.
+    * @post: staged is empty. Recipes already in the book win, as in addRecipe.
+    * @return: The number of Recipes added.
+    */
+    std::size_t bulkLoad (RecipeStagingList & staged);
+    /**
+    * Applies a batch of adds and removes, e.g. from a sync job.
+    * @param changes The changes, in the order they were made; Recipes to add
+    are moved into their nodes.
+    * @post: The book is the same as after calling addRecipe or removeRecipe
+    for each change in order.
+    * @return: For each change in order, what that call would have returned.
+    * @note: The changes are sorted by name and settled one name at a time.
+    Threshold: a batch of m changes is only merged in one pass when m is at
+    least n, the number of Recipes in the book. That pass rebuilds the tree
+    balanced in O(n + m), relinking the nodes it keeps. A smaller batch is
+    applied as m descents in name order, O(m log n), where consecutive
+    descents find the nodes near the top already in cache. The merge reads
+    every name in the book, and long names each cost a cache miss, so it
+    lost below that size: with n = 1M, 62.5k changes took 0.36s merged and
+    0.15s as sorted descents, and the merge only won from m = 2M on.
+    */
+    std::vector<bool> applyBatch (std::vector<RecipeChange> changes);
+    /**
+    * Finds a Recipe in the tree by name, without building a Recipe.
     * @param name A const reference to the name.
     * @return A pointer to the node containing the Recipe with the given
     difficulty level, or nullptr if not found.
     */
     std::shared_ptr<BinaryNode<Recipe>> findRecipe (const std::string & name) const;
+    /**
+    * Finds many Recipes by name at once, e.g. every name of one request.
+    * @param names The names to look up, in any order, repeats allowed.
+    * @return: For each name in order, the Recipe with that name, or nullptr
+    if not found; valid until the book changes.
+    * @note: The names are looked up 16 at a time, a level of each per round
+    (see BinarySearchTree::findBatch), so the cache misses of different
+    names overlap instead of coming one after another.
+    */
+    std::vector<const Recipe *> findMany (const std::vector<std::string_view> & names) const;
 
     /**
     * Adds a Recipe to the tree.
@@ -116,16 +272,38 @@ public:
     */
     bool addRecipe (const Recipe & recipe);
     /**
+    * Builds a Recipe from its fields directly inside a new tree node.
+    * @param name The name of the recipe.
+    * @param difficulty_level The difficulty level of the recipe.
+    * @param description A brief description of the recipe.
+    * @param mastered Indicates whether the recipe has been mastered.
+    * @post: Same as addRecipe, with each string copied once, straight into
+    the node's text.
+    * @return: True if the Recipe was added; false if a Recipe with the same
+    name already exists.
+    */
+    bool emplaceRecipe (std::string_view name, int difficulty_level, std::string_view description, bool mastered);
+    /**
     * Removes a Recipe from the tree by name.
-    * @param name A const reference to a string representing the name of the
-    Recipe.
+    * @param name The name of the Recipe; a std::string, a RecipeText or a
+    literal converts to it without a copy.
     * @post: If found, the Recipe is removed from the tree.
     * @return: True if the Recipe was successfully removed; false otherwise.
     */
-    bool removeRecipe (const std::string & name);
+    bool removeRecipe (std::string_view name);
+    /**
+    * Marks a Recipe as mastered or not mastered.
+    * @param name A const reference to the name of the Recipe.
+    * @param mastered The new value of mastered_.
+    * @post: The Recipe and the mastery index are updated.
+    * @return: True if the Recipe was found; false otherwise.
+    */
+    bool setMastered (const std::string & name, bool mastered);
     /**
     * Clears all Recipes from the tree.
-    * @post: The tree is emptied, and all nodes are deallocated.
+    * @post: The tree is emptied, and the nodes no snapshot holds are freed
+    one by one, in O(n). Their blocks go back to the node pool for the next
+    Recipes added.
     */
     void clear ();
     /**
@@ -146,18 +324,24 @@ public:
     levels must also be mastered.
     * @return: An integer representing the number of mastery points needed, or
     -1 if the Recipe is not found.
-    * Mastery points are calculated as the number of Recipes from the root to
-    the given Recipe (inclusive).
+    * Mastery points are calculated as the number of unmastered Recipes with a
+    difficulty level at or below the given Recipe's, answered in O(log n) from
+    the mastery index.
     */
     int calculateMasteryPoints (const std::string & name ) const;
     /**
+    * Rebuilds the mastery index from the Recipes in the tree.
+    * @post: The index counts every unmastered Recipe by difficulty level.
+    */
+    void rebuildMasteryIndex ();
+    /**
     * In order transveral function
     * @param node A smart pointer that represents the node of a binary tree
     *@param tree A vector of Recipes that represents all the recipes in binary tree
     * @post: Tree vector contains the Recipes inorder transveral form
     *
     */
-    void  inorderhelp (std::shared_ptr<BinaryNode<Recipe>> node, std::vector<Recipe>  &tree );
+    void  inorderhelp (const std::shared_ptr<BinaryNode<Recipe>>& node, std::vector<Recipe>  &tree );
     /**
     * Helps Build the Tree after inorder traversal in order to balance
     *@param tree A vector of Recipes that represents all the recipes in binary tree
@@ -172,17 +356,62 @@ public:
     * Balances the tree.
     * @post: The tree is balanced such that for any node, the heights of its
     left and right subtrees differ by no more than 1.
-    * @note: You may implement this by performing an inorder traversal to get
-    sorted Recipes and rebuilding the tree.
+    * @note: The existing nodes are relinked in place (see
+    BinarySearchTree::balanceInPlace), so no Recipe is copied and nothing is
+    allocated.
     */
     void balance ();
     /**
+    * Compiles the book into a read-only copy laid out for fast lookups.
+    * @return: A FrozenRecipeBook holding a copy of every Recipe; later changes
+    to this book do not affect it. Include FrozenRecipeBook.hpp to use it.
+    */
+    FrozenRecipeBook freeze () const;
+    /**
+    * Saves the book in the compact binary format of MappedRecipeBook.hpp.
+    * @param filename A const reference to the name of the file to write.
+    * @param error Set to a message if the file cannot be written.
+    * @post: The file holds every Recipe, sorted by name; an old file of that
+    name is replaced in one step, once the new one is complete.
+    * @return: True on success; false otherwise.
+    */
+    bool save (const std::string & filename, std::string & error) const;
+    /**
+    * Opens a file written by save without parsing it.
+    * @param filename A const reference to the name of the file.
+    * @param book Set to a read-only book that serves findRecipe straight from
+    the memory-mapped file. Include MappedRecipeBook.hpp to use it.
+    * @param error Set to a message if the file cannot be opened, is damaged, or
+    was saved in another format version.
+    * @return: True on success; false otherwise.
+    */
+    static bool openMapped (const std::string & filename, MappedRecipeBook & book, std::string & error);
+    /**
+    * Chooses whether lookups go through a B+ tree of the nodes by name.
+    * @param enabled True to build the name index and keep it up to date;
+    false to drop it and search the binary tree again.
+    * @note: The B+ tree holds 16 names per node and compares 8 bytes of each
+    at once, so a lookup touches a few nodes instead of one per level. It
+    costs an extra O(log n) step on every add and remove. Turning it on
+    first copies the nodes the book shares with a snapshot, in O(n), so the
+    index only ever points at nodes the book may change.
+    */
+    void useNameIndex (bool enabled);
+    /**
+    * @return: True if lookups go through the name index.
+    */
+    bool usesNameIndex () const;
+    /**
+    * Rebuilds the name index from the nodes of the tree, if the book uses one.
+    */
+    void rebuildNameIndex ();
+    /**
     * Helper Fucntion that helps Displays the tree in preorder traversal 
     *@param node a smart pointer that contains the node
     * @post: Outputs the Recipes in the tree in preorder, formatted as:
     */
 
-    void preorderDisplayhelp ( std::shared_ptr<BinaryNode<Recipe>> node )const;
+    void preorderDisplayhelp (const std::shared_ptr<BinaryNode<Recipe>>& node )const;
     /**
     * Displays the tree in preorder traversal.
     * @post: Outputs the Recipes in the tree in preorder, formatted as:
@@ -194,6 +423,23 @@ public:
     */
     void preorderDisplay () const;
 
+private:
+    MasteryIndex mastery_index_; // unmastered Recipes counted by difficulty level
+    bool use_name_index_ = false; // findRecipe searches name_index_
+    RecipeNameIndex name_index_; // the tree's nodes by name, when use_name_index_
+    TextPool descriptions_; // one shared block per distinct long description added; not copied with the book
+    /**
+    * Counts every unmastered Recipe of a subtree in the mastery index.
+    * @param node A const reference to the root of the subtree.
+    */
+    void indexMasteryHelper (const std::shared_ptr<BinaryNode<Recipe>>& node);
+    /**
+    * Interns the description of a Recipe that was just added.
+    * @param node A const reference to the new node, owned by this book.
+    * @post: The node's description shares the pool's block for its text.
+    */
+    void internDescription (const std::shared_ptr<BinaryNode<Recipe>>& node);
+
 };
 
 
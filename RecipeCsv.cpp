@@ -0,0 +1,278 @@
+/**
+ * @file RecipeCsv.cpp
+ * @brief Definitions of the fast recipe CSV reader declared in RecipeCsv.hpp.
+ */
+#include "RecipeCsv.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <iterator>
+
+static const std::size_t kMinChunkBytes = 1 << 20; // smaller pieces are not worth a thread
+
+/**
+* Cuts the next field off the front of a line.
+* @param line The rest of the line; the field and its comma are removed.
+* @return The field, without the comma.
+*/
+static std::string_view nextField (std::string_view & line) {
+    if (line.empty()) { // no field left
+        return line;
+    }
+    const void * comma = std::memchr(line.data(), ',', line.size());
+    if (comma == nullptr) { // last field
+        std::string_view field = line;
+        line = std::string_view();
+        return field;
+    }
+    std::size_t length = static_cast<const char *>(comma) - line.data();
+    std::string_view field = line.substr(0, length);
+    line.remove_prefix(length + 1);
+    return field;
+}
+
+/**
+* Parses whole lines of a recipe CSV export.
+* @param text The lines to parse.
+* @param has_header True if the first line of text is the header.
+* @param recipes The parsed Recipes are appended here, in file order.
+* @param bad_line Set to the number of the first bad line, counted from 1 in text.
+* @param reason Set to what is wrong with that line.
+* @return: True if every line parsed; false otherwise.
+*/
+static bool parseLines (std::string_view text, bool has_header, std::vector<Recipe> & recipes, std::size_t & bad_line, std::string & reason) {
+    recipes.reserve(recipes.size() + std::count(text.begin(), text.end(), '\n'));
+    TextPool descriptions; // each piece stores a repeated description once; bulkLoad dedups across pieces
+    std::size_t line_number = 0;
+    while (!text.empty()) {
+        // cut the next line off the text
+        const void * newline = std::memchr(text.data(), '\n', text.size());
+        std::size_t length = newline == nullptr ? text.size() : static_cast<const char *>(newline) - text.data();
+        std::string_view line = text.substr(0, length);
+        text.remove_prefix(newline == nullptr ? length : length + 1);
+        line_number++;
+
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if ((has_header && line_number == 1) || line.empty()) { // header or blank line
+            continue;
+        }
+
+        std::string_view name = nextField(line);
+        if (line.empty()) {
+            bad_line = line_number;
+            reason = "missing difficulty_level";
+            return false;
+        }
+        std::string_view level = nextField(line);
+        std::string_view digits = level;
+        while (!digits.empty() && std::isspace(static_cast<unsigned char>(digits.front()))) { // skipped by stoi, as the old loader did
+            digits.remove_prefix(1);
+        }
+        if (!digits.empty() && digits.front() == '+' && digits.size() > 1 && digits[1] != '-') {
+            digits.remove_prefix(1);
+        }
+        int difficulty_level = 0;
+        std::from_chars_result parsed = std::from_chars(digits.data(), digits.data() + digits.size(), difficulty_level);
+        if (parsed.ec != std::errc() || parsed.ptr != digits.data() + digits.size()) { // "3abc" is not 3
+            bad_line = line_number;
+            reason = "bad difficulty_level \"" + std::string(level) + "\"";
+            return false;
+        }
+        std::string_view description = nextField(line);
+        std::string_view mastered = nextField(line);
+
+        recipes.emplace_back(RecipeText(name), difficulty_level, descriptions.intern(description),
+                             mastered != "0"); // only "0" is unmastered, even an empty or missing field
+    }
+    return true;
+}
+
+/**
+* Parses the text of a recipe CSV export.
+* @param text The whole file, header line included.
+* @param recipes The parsed Recipes are appended here, in file order.
+* @param error Set to a message naming the first bad line, if any.
+* @return: True if every line parsed; false otherwise.
+*/
+bool parseRecipeCsv (std::string_view text, std::vector<Recipe> & recipes, std::string & error) {
+    std::size_t bad_line = 0;
+    std::string reason;
+    if (!parseLines(text, true, recipes, bad_line, reason)) {
+        error = "line " + std::to_string(bad_line) + ": " + reason;
+        return false;
+    }
+    return true;
+}
+
+/**
+* The Recipes of one piece of the file, sorted by name once parsed.
+*/
+struct SortedRun {
+    std::vector<Recipe> recipes;
+    bool parsed = false;
+    std::size_t bad_line = 0; // counted from 1 in the piece
+    std::string reason;
+};
+
+/**
+* Orders Recipes by name only, so equal names keep their file order in a
+stable sort or merge.
+*/
+static bool nameLess (const Recipe & a, const Recipe & b) {
+    return a.name_ < b.name_;
+}
+
+/**
+* Merges two runs; on equal names the Recipe of first comes first.
+* @param first The run of the earlier piece of the file.
+* @param second The run of the later piece.
+* @return: The merged run.
+*/
+static SortedRun mergeRuns (SortedRun & first, SortedRun & second) {
+    SortedRun merged;
+    merged.parsed = true;
+    if (first.recipes.empty() || second.recipes.empty() || !nameLess(second.recipes.front(), first.recipes.back())) {
+        merged.recipes = std::move(first.recipes); // already in order, as sorted exports are
+        merged.recipes.insert(merged.recipes.end(), std::make_move_iterator(second.recipes.begin()), std::make_move_iterator(second.recipes.end()));
+    }
+    else {
+        merged.recipes.reserve(first.recipes.size() + second.recipes.size());
+        std::merge(std::make_move_iterator(first.recipes.begin()), std::make_move_iterator(first.recipes.end()),
+                   std::make_move_iterator(second.recipes.begin()), std::make_move_iterator(second.recipes.end()),
+                   std::back_inserter(merged.recipes), nameLess); // takes from first on ties
+    }
+    first.recipes = std::vector<Recipe>();
+    second.recipes = std::vector<Recipe>();
+    return merged;
+}
+
+/**
+* Parses the text of a recipe CSV export on several threads.
+* @param text The whole file, header line included.
+* @param recipes The parsed Recipes are appended here, sorted by name;
+Recipes with the same name stay in file order.
+* @param error Set to a message naming the first bad line, if any.
+* @param threads The most threads to use; 0 means one per core.
+* @return: True if every line parsed; false otherwise (recipes is then unchanged).
+*/
+bool parseRecipeCsvSorted (std::string_view text, std::vector<Recipe> & recipes, std::string & error, unsigned threads) {
+    ThreadPool & pool = ThreadPool::shared();
+    if (threads == 0) {
+        threads = pool.getWorkerCount() + 1; // the workers and this thread
+    }
+    std::size_t piece_count = std::min<std::size_t>(threads, text.size() / kMinChunkBytes + 1);
+
+    // cut the text into pieces of whole lines, about the same size each
+    std::vector<std::string_view> pieces;
+    std::size_t start = 0;
+    for (std::size_t i = 1; i <= piece_count && start < text.size(); i++) {
+        std::size_t end = std::max(start, text.size() / piece_count * i);
+        if (i == piece_count) {
+            end = text.size();
+        }
+        else if (end < text.size()) {
+            const void * newline = std::memchr(text.data() + end, '\n', text.size() - end);
+            end = newline == nullptr ? text.size() : static_cast<const char *>(newline) - text.data() + 1;
+        }
+        pieces.push_back(text.substr(start, end - start));
+        start = end;
+    }
+
+    // every piece is parsed and sorted as its own task on the library's thread pool
+    std::vector<SortedRun> runs(pieces.size());
+    auto parse_piece = [&pieces, &runs](std::size_t i) {
+        SortedRun & run = runs[i];
+        run.parsed = parseLines(pieces[i], i == 0, run.recipes, run.bad_line, run.reason);
+        if (run.parsed && !std::is_sorted(run.recipes.begin(), run.recipes.end(), nameLess)) {
+            std::stable_sort(run.recipes.begin(), run.recipes.end(), nameLess);
+        }
+    };
+    ThreadPool::TaskGroup group(pool);
+    for (std::size_t i = 1; i < pieces.size(); i++) {
+        group.run([&parse_piece, i]() { parse_piece(i); });
+    }
+    if (!pieces.empty()) {
+        parse_piece(0);
+    }
+    group.wait();
+
+    for (std::size_t i = 0; i < runs.size(); i++) {
+        if (!runs[i].parsed) { // the line number counts the lines of the earlier pieces
+            std::size_t lines_before = 0;
+            for (std::size_t j = 0; j < i; j++) {
+                lines_before += std::count(pieces[j].begin(), pieces[j].end(), '\n');
+            }
+            error = "line " + std::to_string(lines_before + runs[i].bad_line) + ": " + runs[i].reason;
+            return false;
+        }
+    }
+
+    // neighbouring runs are merged in pairs, each pair as its own task, until one is left
+    while (runs.size() > 1) {
+        std::vector<SortedRun> merged(runs.size() / 2);
+        for (std::size_t i = 1; i < merged.size(); i++) {
+            group.run([&runs, &merged, i]() { merged[i] = mergeRuns(runs[2 * i], runs[2 * i + 1]); });
+        }
+        merged[0] = mergeRuns(runs[0], runs[1]);
+        group.wait();
+        if (runs.size() % 2 == 1) { // the last run waits for the next round
+            merged.push_back(std::move(runs.back()));
+        }
+        runs = std::move(merged);
+    }
+
+    if (!runs.empty()) {
+        if (recipes.empty()) {
+            recipes = std::move(runs[0].recipes);
+        }
+        else {
+            recipes.insert(recipes.end(), std::make_move_iterator(runs[0].recipes.begin()), std::make_move_iterator(runs[0].recipes.end()));
+        }
+    }
+    return true;
+}
+
+/**
+* Reads and parses a recipe CSV export.
+* @param filename The name of the CSV file.
+* @param recipes The parsed Recipes are appended here, in file order.
+* @param error Set to a message if the file cannot be read or parsed.
+* @return: True on success; false otherwise.
+*/
+bool readRecipeCsv (const std::string & filename, std::vector<Recipe> & recipes, std::string & error) {
+    MappedFile file;
+    if (!file.open(filename, error)) {
+        return false;
+    }
+    if (!parseRecipeCsv(file.getContents(), recipes, error)) {
+        error = filename + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+/**
+* Reads and parses a recipe CSV export on several threads.
+* @param filename The name of the CSV file.
+* @param recipes The parsed Recipes are appended here, sorted by name;
+Recipes with the same name stay in file order.
+* @param error Set to a message if the file cannot be read or parsed.
+* @param threads The most threads to use; 0 means one per core.
+* @return: True on success; false otherwise.
+*/
+bool readRecipeCsvSorted (const std::string & filename, std::vector<Recipe> & recipes, std::string & error, unsigned threads) {
+    MappedFile file;
+    if (!file.open(filename, error)) {
+        return false;
+    }
+    if (!parseRecipeCsvSorted(file.getContents(), recipes, error, threads)) {
+        error = filename + ": " + error;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file RecipeCsv.hpp
+ * @brief Fast reader for recipe exports in the format
+ * name,difficulty_level,description,mastered
+ * The first line is a header and is skipped. The file is memory-mapped (see
+ * MappedFile.hpp) and cut into std::string_view fields with memchr, which
+ * the C library vectorizes, and difficulty levels are parsed with
+ * std::from_chars, so no per-line stream or temporary string is created.
+ * The Sorted variants cut a large file into pieces of whole lines, one per
+ * thread; each piece is parsed and sorted as a task on the library's thread
+ * pool (see ThreadPool.hpp), and the sorted runs are merged in pairs as
+ * tasks as well, so the result is ready for RecipeBook::bulkLoad without
+ * sorting it again.
+ */
+#ifndef RECIPE_CSV
+#define RECIPE_CSV
+#include "RecipeBook.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+* Parses the text of a recipe CSV export.
+* @param text The whole file, header line included.
+* @param recipes The parsed Recipes are appended here, in file order.
+* @param error Set to a message naming the first bad line, if any.
+* @note: Lines load as the original stream-based loader read them: a
+difficulty level may start with whitespace or '+', and a mastered field
+other than 0, even an empty or missing one, means mastered. Unlike that
+loader, blank lines are skipped, a trailing '\r' is ignored (so "0\r" is not
+mastered), and a difficulty level with anything after its digits makes the
+line bad instead of being read up to them.
+* @return: True if every line parsed; false otherwise (recipes then holds the
+lines before the bad one).
+*/
+bool parseRecipeCsv (std::string_view text, std::vector<Recipe> & recipes, std::string & error);
+
+/**
+* Reads and parses a recipe CSV export.
+* @param filename The name of the CSV file.
+* @param recipes The parsed Recipes are appended here, in file order.
+* @param error Set to a message if the file cannot be read or parsed.
+* @return: True on success; false otherwise.
+*/
+bool readRecipeCsv (const std::string & filename, std::vector<Recipe> & recipes, std::string & error);
+
+/**
+* Parses the text of a recipe CSV export on several threads.
+* @param text The whole file, header line included.
+* @param recipes The parsed Recipes are appended here, sorted by name;
+Recipes with the same name stay in file order, so the first one can win.
+* @param error Set to a message naming the first bad line, if any.
+* @param threads The most threads to use; 0 means one per core. Files under
+about a megabyte per thread use fewer threads.
+* @return: True if every line parsed; false otherwise (recipes is then unchanged).
+*/
+bool parseRecipeCsvSorted (std::string_view text, std::vector<Recipe> & recipes, std::string & error, unsigned threads = 0);
+
+/**
+* Reads and parses a recipe CSV export on several threads.
+* @param filename The name of the CSV file.
+* @param recipes The parsed Recipes are appended here, as by parseRecipeCsvSorted.
+* @param error Set to a message if the file cannot be read or parsed.
+* @param threads The most threads to use; 0 means one per core.
+* @return: True on success; false otherwise.
+*/
+bool readRecipeCsvSorted (const std::string & filename, std::vector<Recipe> & recipes, std::string & error, unsigned threads = 0);
+
+#endif
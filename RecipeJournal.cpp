@@ -0,0 +1,539 @@
+/** @file RecipeJournal.cpp */
+
+#include "RecipeJournal.hpp"
+#include "MappedFile.hpp"
+#include "MappedRecipeBook.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RECIPE_JOURNAL_USE_FSYNC 1
+#include <unistd.h>
+#endif
+
+namespace
+{
+const char kLogMagic[8] = {'R', 'C', 'P', 'L', 'O', 'G', '\0', '\0'};
+const std::uint32_t kLogVersion = 1;
+const std::uint32_t kByteOrderMark = 0x01020304;
+const std::size_t kLogHeaderSize = 16;  // magic, version, byte order mark
+const std::size_t kRecordHeaderSize = 8; // payload length, payload checksum
+const std::size_t kBatchBytes = 1 << 20; // unsynced commits hand the log to the OS in batches this big
+
+// The first byte of every payload
+enum Change : unsigned char
+{
+  kAdd = 1,      // difficulty_level_, mastered_, name, description
+  kRemove = 2,   // name
+  kMastered = 3, // mastered_, name
+  kClear = 4
+};
+
+template <class U>
+void put(std::string &out, U value)
+{
+  out.append(reinterpret_cast<const char *>(&value), sizeof(U));
+} // end put
+
+void putString(std::string &out, std::string_view text)
+{
+  put<std::uint32_t>(out, static_cast<std::uint32_t>(text.size()));
+  out.append(text.data(), text.size());
+} // end putString
+
+template <class U>
+bool take(std::string_view &in, U &value)
+{
+  if (in.size() < sizeof(U))
+    return false;
+  std::memcpy(&value, in.data(), sizeof(U));
+  in.remove_prefix(sizeof(U));
+  return true;
+} // end take
+
+bool takeString(std::string_view &in, std::string_view &text)
+{
+  std::uint32_t length = 0;
+  if (!take(in, length) || in.size() < length)
+    return false;
+  text = in.substr(0, length);
+  in.remove_prefix(length);
+  return true;
+} // end takeString
+
+/** @return the 32-bit FNV-1a hash of data **/
+std::uint32_t checksum(std::string_view data)
+{
+  std::uint32_t sum = 2166136261u;
+  for (char byte : data)
+    sum = (sum ^ static_cast<unsigned char>(byte)) * 16777619u;
+  return sum;
+} // end checksum
+
+/** @return payload framed as a record: its length, its checksum, then itself **/
+std::string frame(const std::string &payload)
+{
+  std::string record;
+  record.reserve(kRecordHeaderSize + payload.size());
+  put<std::uint32_t>(record, static_cast<std::uint32_t>(payload.size()));
+  put<std::uint32_t>(record, checksum(payload));
+  record += payload;
+  return record;
+} // end frame
+
+/** @return the header every log starts with **/
+std::string logHeader()
+{
+  std::string header(kLogMagic, sizeof(kLogMagic));
+  put<std::uint32_t>(header, kLogVersion);
+  put<std::uint32_t>(header, kByteOrderMark);
+  return header;
+} // end logHeader
+
+/** @param payload one change, checksum already verified
+    @post the change is made to book
+    @return false if the payload is malformed **/
+bool apply(std::string_view payload, RecipeBook &book)
+{
+  unsigned char change = 0;
+  std::string_view name, description;
+  if (!take(payload, change))
+    return false;
+  switch (change)
+  {
+  case kAdd:
+  {
+    std::int32_t difficulty_level = 0;
+    unsigned char mastered = 0;
+    if (!take(payload, difficulty_level) || !take(payload, mastered) || !takeString(payload, name) || !takeString(payload, description))
+      return false;
+    book.addRecipe(Recipe(RecipeText(name), difficulty_level, RecipeText(description), mastered != 0));
+    return true;
+  }
+  case kRemove:
+    if (!takeString(payload, name))
+      return false;
+    book.removeRecipe(name);
+    return true;
+  case kMastered:
+  {
+    unsigned char mastered = 0;
+    if (!take(payload, mastered) || !takeString(payload, name))
+      return false;
+    book.setMastered(std::string(name), mastered != 0);
+    return true;
+  }
+  case kClear:
+    book.clear();
+    return true;
+  default:
+    return false;
+  }
+} // end apply
+
+/** @return the directory holding filename, for syncing a rename in it **/
+std::string directoryOf(const std::string &filename)
+{
+  std::filesystem::path parent = std::filesystem::path(filename).parent_path();
+  return parent.empty() ? std::string(".") : parent.string();
+} // end directoryOf
+} // namespace
+
+RecipeJournal::RecipeJournal()
+    : log_(nullptr), appended_(0), written_(0), synced_(0), flushing_(false), log_bytes_(0), compacting_(false)
+{
+} // end default constructor
+
+RecipeJournal::~RecipeJournal()
+{
+  waitForCompaction();
+  if (log_ != nullptr)
+  {
+    flush();
+    std::fclose(log_);
+  }
+} // end destructor
+
+bool RecipeJournal::open(const std::string &path, RecipeBook &book, std::string &error, Options options)
+{
+  if (log_ != nullptr)
+  {
+    error = path + ": the journal is already open";
+    return false;
+  }
+  path_ = path;
+  options_ = options;
+  std::string log = path + ".log", old_log = log + ".old";
+
+  // The snapshot goes in with one bulk load, straight from the mapped file
+  book.clear();
+  std::error_code ec;
+  if (std::filesystem::exists(path, ec))
+  {
+    MappedRecipeBook snapshot;
+    if (!RecipeBook::openMapped(path, snapshot, error))
+      return false;
+    std::vector<Recipe> recipes;
+    recipes.reserve(snapshot.size());
+    for (std::size_t i = 0; i < snapshot.size(); i++)
+      recipes.push_back(snapshot.getRecipe(i).toRecipe());
+    book.bulkLoad(std::move(recipes));
+  }
+
+  // Then the changes since, older log first. path.log.old was synced
+  // whole before it was set aside, so a bad record there is corruption;
+  // only path.log can end in a record torn by a crash, which is cut off so
+  // nothing is ever appended after it
+  for (const std::string &filename : {old_log, log})
+  {
+    std::uint64_t good = 0;
+    if (!replay(filename, book, filename == old_log, good, error))
+    {
+      book.clear();
+      return false;
+    }
+    if (!std::filesystem::exists(filename, ec) || std::filesystem::file_size(filename, ec) == good)
+      continue;
+    if (good < kLogHeaderSize)
+      std::filesystem::remove(filename, ec); // a header cut short; a new log gets a whole one
+    else
+      std::filesystem::resize_file(filename, good, ec);
+    if (ec)
+    {
+      error = "cannot truncate " + filename + ": " + ec.message();
+      book.clear();
+      return false;
+    }
+  }
+  std::filesystem::remove(old_log + ".tmp", ec); // a rotation that never finished
+
+  log_ = openLog(log);
+  if (log_ == nullptr)
+  {
+    error = "cannot open " + log + ": " + std::strerror(errno);
+    return false;
+  }
+  log_bytes_ = std::filesystem::file_size(log, ec);
+  return true;
+} // end open
+
+std::uint64_t RecipeJournal::logAdd(const Recipe &recipe)
+{
+  std::string payload(1, static_cast<char>(kAdd));
+  put<std::int32_t>(payload, recipe.difficulty_level_);
+  put<unsigned char>(payload, recipe.mastered_ ? 1 : 0);
+  putString(payload, recipe.name_);
+  putString(payload, recipe.description_);
+  return append(frame(payload));
+} // end logAdd
+
+std::uint64_t RecipeJournal::logRemove(std::string_view name)
+{
+  std::string payload(1, static_cast<char>(kRemove));
+  putString(payload, name);
+  return append(frame(payload));
+} // end logRemove
+
+std::uint64_t RecipeJournal::logSetMastered(std::string_view name, bool mastered)
+{
+  std::string payload(1, static_cast<char>(kMastered));
+  put<unsigned char>(payload, mastered ? 1 : 0);
+  putString(payload, name);
+  return append(frame(payload));
+} // end logSetMastered
+
+std::uint64_t RecipeJournal::logClear()
+{
+  return append(frame(std::string(1, static_cast<char>(kClear))));
+} // end logClear
+
+bool RecipeJournal::commit(std::uint64_t sequence)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (options_.sync_on_commit)
+    return writeUpTo(sequence, true, lock);
+  if (pending_.size() >= kBatchBytes)
+    return writeUpTo(appended_, false, lock);
+  return error_.empty();
+} // end commit
+
+bool RecipeJournal::flush()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  return writeUpTo(appended_, true, lock);
+} // end flush
+
+bool RecipeJournal::needsCompaction() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return options_.compact_bytes > 0 && log_bytes_ + pending_.size() >= options_.compact_bytes && !compacting_.load();
+} // end needsCompaction
+
+bool RecipeJournal::startCompaction(RecipeBook snapshot)
+{
+  waitForCompaction();
+  {
+    // Everything appended so far goes into the log that is set aside, so
+    // the snapshot covers exactly that log
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!writeUpTo(appended_, true, lock) || !rotate())
+      return false;
+  }
+  compacting_ = true;
+  compactor_ = std::thread([this, book = std::move(snapshot)]() {
+    std::string error;
+    std::string old_log = path_ + ".log.old";
+    // The snapshot has to be on disk before the old log can go
+    if (book.save(path_, error) && syncPath(path_) && syncPath(directoryOf(path_)))
+    {
+      std::remove(old_log.c_str());
+      syncPath(directoryOf(path_));
+    }
+    else
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      compaction_error_ = error.empty() ? "cannot sync " + path_ : error;
+    }
+    compacting_ = false;
+  });
+  return true;
+} // end startCompaction
+
+bool RecipeJournal::waitForCompaction()
+{
+  if (compactor_.joinable())
+    compactor_.join();
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool succeeded = compaction_error_.empty();
+  if (!succeeded && error_.empty())
+    error_ = compaction_error_;
+  compaction_error_.clear();
+  return succeeded;
+} // end waitForCompaction
+
+std::uint64_t RecipeJournal::getLogBytes() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return log_bytes_ + pending_.size();
+} // end getLogBytes
+
+std::string RecipeJournal::getError() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return error_;
+} // end getError
+
+std::uint64_t RecipeJournal::append(const std::string &record)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_ += record;
+  return ++appended_;
+} // end append
+
+bool RecipeJournal::writeUpTo(std::uint64_t sequence, bool sync, std::unique_lock<std::mutex> &lock)
+{
+  while ((sync ? synced_ : written_) < sequence)
+  {
+    if (!error_.empty())
+      return false;
+    if (flushing_)
+    {
+      // Another thread's batch may already hold this record
+      flushed_.wait(lock);
+      continue;
+    }
+    // Lead: take every record appended so far, so the threads that queue
+    // up meanwhile are covered by the next single write and sync
+    flushing_ = true;
+    std::string batch;
+    batch.swap(pending_);
+    std::uint64_t last = appended_;
+    lock.unlock();
+    bool written = writeBatch(batch, sync);
+    lock.lock();
+    flushing_ = false;
+    if (written)
+    {
+      written_ = last;
+      if (sync)
+        synced_ = last;
+      log_bytes_ += batch.size();
+    }
+    else if (error_.empty())
+      error_ = "cannot write " + path_ + ".log: " + std::strerror(errno);
+    flushed_.notify_all();
+  }
+  return error_.empty();
+} // end writeUpTo
+
+bool RecipeJournal::writeBatch(const std::string &data, bool sync)
+{
+  if (log_ == nullptr)
+    return false;
+  if (std::fwrite(data.data(), 1, data.size(), log_) != data.size() || std::fflush(log_) != 0)
+    return false;
+#ifdef RECIPE_JOURNAL_USE_FSYNC
+  if (sync && ::fsync(::fileno(log_)) != 0)
+    return false;
+#endif
+  return true;
+} // end writeBatch
+
+bool RecipeJournal::rotate()
+{
+  std::string log = path_ + ".log", old_log = log + ".old";
+  std::fclose(log_);
+  log_ = nullptr;
+  std::error_code ec;
+  if (!std::filesystem::exists(old_log, ec))
+    std::filesystem::rename(log, old_log, ec);
+  else
+  {
+    // The last compaction failed, so path.log.old holds changes the
+    // snapshot on disk lacks, and these go after them. Both are copied to
+    // a new file that replaces path.log.old in one rename: a crash before
+    // it leaves the two logs as they were, and one after it only replays
+    // these changes twice, which changes nothing
+    std::string merged = old_log + ".tmp";
+    MappedFile older, newer;
+    std::string ignored;
+    std::FILE *merged_file = std::fopen(merged.c_str(), "wb");
+    bool moved = merged_file != nullptr && older.open(old_log, ignored) && newer.open(log, ignored);
+    if (moved)
+    {
+      std::string_view front = older.getContents();
+      std::string_view records = newer.getContents().substr(std::min(kLogHeaderSize, newer.getContents().size()));
+      moved = std::fwrite(front.data(), 1, front.size(), merged_file) == front.size() &&
+              std::fwrite(records.data(), 1, records.size(), merged_file) == records.size() &&
+              std::fflush(merged_file) == 0;
+#ifdef RECIPE_JOURNAL_USE_FSYNC
+      moved = moved && ::fsync(::fileno(merged_file)) == 0;
+#endif
+    }
+    if (merged_file != nullptr)
+      std::fclose(merged_file);
+    if (moved)
+      std::filesystem::rename(merged, old_log, ec);
+    if (!moved || (!ec && !syncPath(directoryOf(path_))))
+      ec = std::make_error_code(std::errc::io_error);
+    if (!ec)
+      std::filesystem::remove(log, ec);
+    std::error_code not_left;
+    std::filesystem::remove(merged, not_left); // already gone once renamed
+  }
+  if (ec)
+  {
+    error_ = "cannot set " + log + " aside: " + ec.message();
+    return false;
+  }
+  log_ = openLog(log);
+  if (log_ == nullptr || !syncPath(directoryOf(path_)))
+  {
+    error_ = "cannot start a new " + log;
+    return false;
+  }
+  log_bytes_ = kLogHeaderSize;
+  return true;
+} // end rotate
+
+bool RecipeJournal::replay(const std::string &filename, RecipeBook &book, bool synced, std::uint64_t &good,
+                           std::string &error)
+{
+  good = 0;
+  std::error_code ec;
+  if (!std::filesystem::exists(filename, ec))
+    return true;
+  MappedFile file;
+  if (!file.open(filename, error))
+    return false;
+  std::string_view contents = file.getContents();
+  std::string expected = logHeader();
+  if (contents.size() < kLogHeaderSize)
+  {
+    // Only a new log whose header was being written when the machine went
+    // down can be this short
+    if (!synced && expected.compare(0, contents.size(), contents) == 0)
+      return true;
+    error = filename + ": log header is incomplete";
+    return false;
+  }
+  std::string_view header = contents.substr(0, kLogHeaderSize);
+  std::uint32_t version = 0, byte_order = 0;
+  if (std::memcmp(header.data(), kLogMagic, sizeof(kLogMagic)) != 0)
+  {
+    error = filename + ": not a recipe log";
+    return false;
+  }
+  header.remove_prefix(sizeof(kLogMagic));
+  take(header, version);
+  take(header, byte_order);
+  if (byte_order != kByteOrderMark)
+  {
+    error = filename + ": written on a machine with the other byte order";
+    return false;
+  }
+  if (version != kLogVersion)
+  {
+    error = filename + ": log version " + std::to_string(version) + ", expected " + std::to_string(kLogVersion);
+    return false;
+  }
+
+  std::string_view rest = contents.substr(kLogHeaderSize);
+  while (!rest.empty())
+  {
+    // A record that is short or fails its checksum is where the last write
+    // was cut off; nothing after it counts
+    std::string_view record = rest;
+    std::uint32_t length = 0, sum = 0;
+    if (!take(record, length) || !take(record, sum) || record.size() < length ||
+        checksum(record.substr(0, length)) != sum)
+    {
+      if (!synced)
+        break;
+      error = filename + ": bad record at byte " + std::to_string(contents.size() - rest.size());
+      return false;
+    }
+    // One that checks out but cannot be applied was written wrong
+    if (!apply(record.substr(0, length), book))
+    {
+      error = filename + ": malformed change at byte " + std::to_string(contents.size() - rest.size());
+      return false;
+    }
+    rest.remove_prefix(kRecordHeaderSize + length);
+  }
+  good = contents.size() - rest.size();
+  return true;
+} // end replay
+
+std::FILE *RecipeJournal::openLog(const std::string &filename)
+{
+  std::FILE *file = std::fopen(filename.c_str(), "ab");
+  if (file == nullptr)
+    return nullptr;
+  std::fseek(file, 0, SEEK_END);
+  if (std::ftell(file) == 0)
+  {
+    // Synced straight away, so a log set aside before anything is
+    // committed to it still has a whole header
+    std::string header = logHeader();
+    bool written = std::fwrite(header.data(), 1, header.size(), file) == header.size() && std::fflush(file) == 0;
+#ifdef RECIPE_JOURNAL_USE_FSYNC
+    written = written && ::fsync(::fileno(file)) == 0;
+#endif
+    if (!written)
+    {
+      std::fclose(file);
+      return nullptr;
+    }
+  }
+  return file;
+} // end openLog
+
+bool RecipeJournal::syncPath(const std::string &filename)
+{
+  return MappedFile::syncPath(filename);
+} // end syncPath
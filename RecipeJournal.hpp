@@ -0,0 +1,167 @@
+/** An append-only write-ahead log of the changes made to a RecipeBook.
+ A journal at path keeps two kinds of files: path itself, a snapshot saved
+ by RecipeBook::save, and path.log, the changes made since, each appended
+ as a compact binary record (add, remove, mastered flag, clear) with its own
+ length and checksum. Opening the journal loads the snapshot and replays
+ only the log; a record cut short by a crash ends path.log and is dropped,
+ while a log with a foreign header or a corrupt record in a log that was
+ already synced stops the open with an error.
+ Group commit: appending a change only copies it into memory. commit waits
+ until the change is on disk; the first thread to wait writes everything
+ appended so far and syncs it once, while the threads behind it wait for
+ that one sync instead of each doing their own.
+ Compaction: once the log passes Options::compact_bytes, the caller hands
+ over a snapshot of the book (RecipeBook::snapshot is O(1)). The log is
+ renamed to path.log.old and a new one started, then the snapshot is saved
+ over path on a background thread and path.log.old deleted. Replaying a
+ change on a book that already has it changes nothing, so a crash at any
+ point leaves a snapshot and logs that replay to the right book.
+ Not thread-safe for changes: the caller keeps the order in which changes
+ are made to the book and appended to the journal the same (see
+ ConcurrentRecipeBook::openJournal). commit may be called from any thread.
+ @file RecipeJournal.hpp */
+
+#ifndef RECIPE_JOURNAL_
+#define RECIPE_JOURNAL_
+
+#include "RecipeBook.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+class RecipeJournal
+{
+public:
+  struct Options
+  {
+    bool sync_on_commit;         // false: commit only hands full batches to the OS, and flush syncs
+    std::uint64_t compact_bytes; // log size that asks for a compaction; 0 for never
+    Options() : sync_on_commit(true), compact_bytes(64 << 20) {}
+  };
+
+  RecipeJournal();
+
+  /** @post everything appended is written and synced, and a running
+            compaction has finished **/
+  ~RecipeJournal();
+
+  RecipeJournal(const RecipeJournal &) = delete;
+  RecipeJournal &operator=(const RecipeJournal &) = delete;
+
+  /** @param path the snapshot file; the logs are path.log and path.log.old
+      @param book set to the snapshot with both logs replayed on top; it
+             starts out empty if none of the files exist yet
+      @param error set to a message if a file cannot be read or written, is
+             not a log of this version and byte order, or is corrupt
+      @param options when to sync and when to compact
+      @post a torn record at the end of path.log is cut off, and new
+            changes are appended after the last whole one
+      @return true if the journal is open; false leaves book empty and
+              every file as it was **/
+  bool open(const std::string &path, RecipeBook &book, std::string &error, Options options = Options());
+
+  /** Each of these appends one change, already made to the book, and
+      returns its sequence number for commit. **/
+  std::uint64_t logAdd(const Recipe &recipe);
+  std::uint64_t logRemove(std::string_view name);
+  std::uint64_t logSetMastered(std::string_view name, bool mastered);
+  std::uint64_t logClear();
+
+  /** @param sequence a number returned by one of the log methods
+      @post the change and every change before it are written and synced,
+            unless Options::sync_on_commit is false
+      @return false if the log could not be written (see getError) **/
+  bool commit(std::uint64_t sequence);
+
+  /** @post every change appended so far is written and synced
+      @return false if the log could not be written **/
+  bool flush();
+
+  /** @return true if the log has grown past Options::compact_bytes and no
+              compaction is running **/
+  bool needsCompaction() const;
+
+  /** @param snapshot the book with every change appended so far, and no other
+      @post the log is rotated, and the snapshot is saved and the old log
+            removed on a background thread
+      @return false if the log could not be rotated **/
+  bool startCompaction(RecipeBook snapshot);
+
+  /** @post no compaction is running
+      @return false if the last compaction failed (see getError) **/
+  bool waitForCompaction();
+
+  /** @return the size in bytes of path.log **/
+  std::uint64_t getLogBytes() const;
+
+  /** @return a message about the first failure, empty if there was none **/
+  std::string getError() const;
+
+private:
+  std::string path_;
+  Options options_;
+  std::FILE *log_;                  // path.log, opened for appending
+
+  mutable std::mutex mutex_;         // guards everything below
+  std::condition_variable flushed_;  // signalled when a batch is on disk
+  std::string pending_;              // records appended but not written yet
+  std::uint64_t appended_;           // sequence number of the last record appended
+  std::uint64_t written_;            // ... of the last one handed to the OS
+  std::uint64_t synced_;             // ... and of the last one synced to disk
+  bool flushing_;                    // a thread is writing a batch with mutex_ released
+  std::uint64_t log_bytes_;
+  std::string error_;
+  std::string compaction_error_;     // set by the compactor thread, reported by waitForCompaction
+
+  std::thread compactor_;
+  std::atomic<bool> compacting_;
+
+  /** called by the log methods
+      @param record a whole record, length and checksum included
+      @return its sequence number **/
+  std::uint64_t append(const std::string &record);
+
+  /** @param sequence the record that has to be written
+      @param sync whether to sync the log after writing
+      @post with lock held, the records up to sequence are written; one
+            thread writes a whole batch while the others wait for it
+      @return false if the log could not be written **/
+  bool writeUpTo(std::uint64_t sequence, bool sync, std::unique_lock<std::mutex> &lock);
+
+  /** @return true if every byte of data reached the log, then synced if sync **/
+  bool writeBatch(const std::string &data, bool sync);
+
+  /** called by startCompaction
+      @post path.log is added to path.log.old (through path.log.old.tmp if a
+            failed compaction left one), and a new empty path.log is open
+      @return false if a file could not be renamed or created **/
+  bool rotate();
+
+  /** called by open
+      @param filename a log file to replay
+      @param book the book the changes are made to
+      @param synced true for path.log.old, which was synced whole before it
+             was set aside, so a bad record in it is corruption rather than
+             a tail torn by a crash
+      @param good set to the byte offset after the last whole record; 0 if
+             the file is missing or its header was cut short
+      @param error set to a message if the file cannot be read, is not a
+             log of this version and byte order, or is corrupt
+      @return true if every whole record was replayed **/
+  static bool replay(const std::string &filename, RecipeBook &book, bool synced, std::uint64_t &good,
+                     std::string &error);
+
+  /** @return filename opened for appending, starting with a synced log
+              header if it is new **/
+  static std::FILE *openLog(const std::string &filename);
+
+  /** @return true if the file or directory named is synced to disk **/
+  static bool syncPath(const std::string &filename);
+};
+
+#endif
@@ -0,0 +1,204 @@
+/** Recovery test of RecipeJournal.
+ Each case writes a journal, damages or interrupts it the way a crash or a
+ foreign file would, and reopens it: a torn record at the end of path.log
+ is cut off, a log with the wrong header or a corrupt path.log.old stops
+ the open with an error and leaves the files alone, and changes set aside
+ by a compaction that failed survive the next rotation. Build and run with
+ "make check".
+ @file RecipeJournalTest.cpp */
+
+#include "RecipeJournal.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace
+{
+namespace fs = std::filesystem;
+
+bool passed = true;
+
+void expect(bool condition, const char *test, const char *what)
+{
+  if (!condition)
+  {
+    std::printf("%s: %s\n", test, what);
+    passed = false;
+  }
+}
+
+/** @return a path for the journal in a new, empty directory **/
+std::string freshPath(const char *test)
+{
+  fs::path directory = fs::temp_directory_path() / ("recipe_journal_test_" + std::string(test));
+  fs::remove_all(directory);
+  fs::create_directories(directory);
+  return (directory / "book").string();
+}
+
+void addAndLog(RecipeBook &book, RecipeJournal &journal, const std::string &name)
+{
+  Recipe recipe(name, 3, "stir well", false);
+  book.addRecipe(recipe);
+  journal.commit(journal.logAdd(recipe));
+}
+
+void removeAndLog(RecipeBook &book, RecipeJournal &journal, const std::string &name)
+{
+  book.removeRecipe(name);
+  journal.commit(journal.logRemove(name));
+}
+
+/** @param offset where to overwrite, from the start or, if negative, the end **/
+void overwrite(const std::string &filename, long offset, const std::string &bytes)
+{
+  std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+  file.seekp(offset, offset < 0 ? std::ios::end : std::ios::beg);
+  file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+void appendBytes(const std::string &filename, const std::string &bytes)
+{
+  std::ofstream file(filename, std::ios::binary | std::ios::app);
+  file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+void testTornTail()
+{
+  const char *test = "torn tail";
+  std::string path = freshPath("torn"), error;
+  {
+    RecipeBook book;
+    RecipeJournal journal;
+    expect(journal.open(path, book, error), test, "first open failed");
+    addAndLog(book, journal, "Soup");
+    addAndLog(book, journal, "Bread");
+  }
+  std::uintmax_t whole = fs::file_size(path + ".log");
+  appendBytes(path + ".log", std::string("\x30\x00\x00\x00\x12\x34", 6)); // a record header and no more
+
+  {
+    RecipeBook book;
+    RecipeJournal journal;
+    expect(journal.open(path, book, error), test, "reopen failed");
+    expect(book.getNumberOfNodes() == 2, test, "whole records lost");
+    expect(fs::file_size(path + ".log") == whole, test, "torn record not cut off");
+    addAndLog(book, journal, "Cake");
+  }
+  RecipeBook book;
+  RecipeJournal journal;
+  expect(journal.open(path, book, error) && book.getNumberOfNodes() == 3, test, "change after the cut lost");
+}
+
+void testBadHeader()
+{
+  const char *test = "bad header";
+  const char *damage[] = {"version", "byte order", "magic"};
+  const long offset[] = {8, 12, 0};
+  for (int i = 0; i < 3; i++)
+  {
+    std::string path = freshPath("header"), error;
+    {
+      RecipeBook book;
+      RecipeJournal journal;
+      journal.open(path, book, error);
+      addAndLog(book, journal, "Soup");
+    }
+    std::uintmax_t size = fs::file_size(path + ".log");
+    overwrite(path + ".log", offset[i], "\x7f");
+
+    RecipeBook book;
+    RecipeJournal journal;
+    error.clear();
+    bool opened = journal.open(path, book, error);
+    if (opened || error.empty() || !fs::exists(path + ".log") || fs::file_size(path + ".log") != size)
+    {
+      std::printf("%s: damaged %s opened or the log was changed\n", test, damage[i]);
+      passed = false;
+    }
+  }
+}
+
+void testCorruptOldLog()
+{
+  const char *test = "corrupt old log";
+  std::string path = freshPath("old"), error;
+  {
+    RecipeBook book;
+    RecipeJournal journal;
+    journal.open(path, book, error);
+    addAndLog(book, journal, "Soup");
+    addAndLog(book, journal, "Bread");
+  }
+  // As if a compaction set the log aside and then failed
+  fs::rename(path + ".log", path + ".log.old");
+  std::uintmax_t size = fs::file_size(path + ".log.old");
+  overwrite(path + ".log.old", -1, "\x7f"); // inside the last record
+
+  RecipeBook book;
+  RecipeJournal journal;
+  error.clear();
+  expect(!journal.open(path, book, error) && !error.empty(), test, "opened a corrupt synced log");
+  expect(fs::file_size(path + ".log.old") == size, test, "synced log was cut");
+  expect(book.getNumberOfNodes() == 0, test, "book left half replayed");
+}
+
+void testFailedCompactionRotatedAgain()
+{
+  const char *test = "failed compaction";
+  std::string path = freshPath("compaction"), error;
+  // A non-empty directory where save writes its temporary file makes
+  // every compaction fail
+  fs::create_directories(path + ".tmp/blocked");
+  {
+    RecipeBook book;
+    RecipeJournal journal;
+    journal.open(path, book, error);
+    addAndLog(book, journal, "Soup");
+    addAndLog(book, journal, "Bread");
+    journal.startCompaction(book.snapshot());
+    expect(!journal.waitForCompaction(), test, "first compaction did not fail");
+  }
+  {
+    // The next run finds path.log.old still there when it rotates
+    RecipeBook book;
+    RecipeJournal journal;
+    expect(journal.open(path, book, error) && book.getNumberOfNodes() == 2, test, "set-aside log not replayed");
+    addAndLog(book, journal, "Cake");
+    removeAndLog(book, journal, "Soup");
+    journal.startCompaction(book.snapshot());
+    expect(!journal.waitForCompaction(), test, "second compaction did not fail");
+  }
+  expect(!fs::exists(path + ".log.old.tmp"), test, "merge file left behind");
+  appendBytes(path + ".log.old.tmp", "a merge cut short by a crash");
+  {
+    RecipeBook book;
+    RecipeJournal journal;
+    expect(journal.open(path, book, error), test, "reopen failed");
+    expect(book.getNumberOfNodes() == 2 && book.findRecipe("Bread") != nullptr && book.findRecipe("Cake") != nullptr,
+           test, "wrong book after two rotations");
+    expect(!fs::exists(path + ".log.old.tmp"), test, "unfinished merge not removed");
+
+    // Once compaction works again the snapshot takes over from both logs
+    fs::remove_all(path + ".tmp");
+    journal.startCompaction(book.snapshot());
+    expect(journal.waitForCompaction() && !fs::exists(path + ".log.old"), test, "compaction after failures failed");
+    addAndLog(book, journal, "Pie");
+  }
+  RecipeBook book;
+  RecipeJournal journal;
+  expect(journal.open(path, book, error) && book.getNumberOfNodes() == 3 && book.findRecipe("Pie") != nullptr, test,
+         "wrong book after compaction");
+}
+} // namespace
+
+int main()
+{
+  testTornTail();
+  testBadHeader();
+  testCorruptOldLog();
+  testFailedCompactionRotatedAgain();
+  std::printf("%s: journal recovery\n", passed ? "passed" : "FAILED");
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+/** @file RecipeText.cpp */
+
+#include "RecipeText.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace
+{
+const std::size_t kMinimumPruneSize = 1024; // no prune passes over a small pool
+} // namespace
+
+RecipeText::RecipeText()
+{
+  bytes_[kInlineCapacity] = 0;
+} // end default constructor
+
+RecipeText::RecipeText(std::string_view text)
+{
+  assign(text);
+} // end constructor
+
+RecipeText::RecipeText(const std::string &text)
+{
+  assign(text);
+} // end constructor
+
+RecipeText::RecipeText(const char *text)
+{
+  assign(text);
+} // end constructor
+
+RecipeText::RecipeText(const RecipeText &other)
+{
+  std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+  if (isShared())
+    block()->references.fetch_add(1, std::memory_order_relaxed);
+} // end copy constructor
+
+RecipeText::RecipeText(RecipeText &&other) noexcept
+{
+  std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+  other.bytes_[kInlineCapacity] = 0; // other keeps no reference
+} // end move constructor
+
+RecipeText &RecipeText::operator=(const RecipeText &other)
+{
+  if (this != &other)
+  {
+    if (other.isShared())
+      other.block()->references.fetch_add(1, std::memory_order_relaxed);
+    release();
+    std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+  }
+  return *this;
+} // end copy assignment
+
+RecipeText &RecipeText::operator=(RecipeText &&other) noexcept
+{
+  if (this != &other)
+  {
+    release();
+    std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+    other.bytes_[kInlineCapacity] = 0;
+  }
+  return *this;
+} // end move assignment
+
+RecipeText::~RecipeText()
+{
+  release();
+} // end destructor
+
+std::string_view RecipeText::view() const
+{
+  if (isShared())
+  {
+    const Block *shared = block();
+    return std::string_view(shared->data, shared->size);
+  }
+  return std::string_view(bytes_, static_cast<unsigned char>(bytes_[kInlineCapacity]));
+} // end view
+
+std::string RecipeText::str() const
+{
+  return std::string(view());
+} // end str
+
+const char *RecipeText::data() const
+{
+  return isShared() ? block()->data : bytes_;
+} // end data
+
+std::size_t RecipeText::size() const
+{
+  return isShared() ? block()->size : static_cast<unsigned char>(bytes_[kInlineCapacity]);
+} // end size
+
+bool RecipeText::empty() const
+{
+  return size() == 0;
+} // end empty
+
+bool RecipeText::isShared() const
+{
+  return static_cast<unsigned char>(bytes_[kInlineCapacity]) == kSharedTag;
+} // end isShared
+
+std::size_t RecipeText::useCount() const
+{
+  // Acquire, so a caller that sees itself as the only holder also sees every
+  // other holder's last use of the block
+  return isShared() ? block()->references.load(std::memory_order_acquire) : 0;
+} // end useCount
+
+RecipeText::Block *RecipeText::block() const
+{
+  Block *shared;
+  std::memcpy(&shared, bytes_, sizeof(shared));
+  return shared;
+} // end block
+
+void RecipeText::assign(std::string_view text)
+{
+  if (text.size() <= kInlineCapacity)
+  {
+    std::memcpy(bytes_, text.data(), text.size());
+    bytes_[kInlineCapacity] = static_cast<char>(text.size());
+    return;
+  }
+  void *memory = ::operator new(offsetof(Block, data) + text.size());
+  Block *shared = new (memory) Block;
+  shared->references.store(1, std::memory_order_relaxed);
+  shared->size = static_cast<std::uint32_t>(text.size());
+  std::memcpy(shared->data, text.data(), text.size());
+  std::memcpy(bytes_, &shared, sizeof(shared));
+  bytes_[kInlineCapacity] = static_cast<char>(kSharedTag);
+} // end assign
+
+void RecipeText::release()
+{
+  if (!isShared())
+    return;
+  Block *shared = block();
+  if (shared->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    shared->~Block();
+    ::operator delete(shared);
+  }
+  bytes_[kInlineCapacity] = 0;
+} // end release
+
+TextPool::TextPool() : prune_at_(kMinimumPruneSize)
+{
+} // end default constructor
+
+RecipeText TextPool::intern(std::string_view text)
+{
+  if (text.size() <= RecipeText::kInlineCapacity)
+    return RecipeText(text); // nothing to share
+  auto found = texts_.find(text);
+  if (found != texts_.end())
+    return found->second;
+  return intern(RecipeText(text));
+} // end intern
+
+RecipeText TextPool::intern(const RecipeText &text)
+{
+  if (!text.isShared())
+    return text;
+  auto found = texts_.find(text.view());
+  if (found != texts_.end())
+    return found->second;
+  if (texts_.size() >= prune_at_)
+  {
+    // Blocks of Recipes since removed pile up otherwise; pruning once the
+    // pool has doubled keeps it O(1) per string, amortized
+    prune();
+    prune_at_ = std::max(kMinimumPruneSize, 2 * texts_.size());
+  }
+  // The key views the block's characters, which stay put while the pool holds it
+  texts_.emplace(text.view(), text);
+  return text;
+} // end intern
+
+std::size_t TextPool::prune()
+{
+  std::size_t freed = 0;
+  for (auto it = texts_.begin(); it != texts_.end();)
+  {
+    if (it->second.useCount() == 1)
+    {
+      it = texts_.erase(it);
+      freed++;
+    }
+    else
+      ++it;
+  }
+  return freed;
+} // end prune
+
+void TextPool::clear()
+{
+  texts_.clear();
+  prune_at_ = kMinimumPruneSize;
+} // end clear
+
+std::size_t TextPool::size() const
+{
+  return texts_.size();
+} // end size
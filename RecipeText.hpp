@@ -0,0 +1,150 @@
+/** Immutable strings for the text fields of a Recipe.
+ A RecipeText is 16 bytes. Up to kInlineCapacity characters are kept inside
+ it; a longer string lives in one shared block with a reference count, so
+ copying a RecipeText never allocates, and every copy of a long string (a
+ Recipe copied out of a tree, a snapshot, a description repeated by many
+ Recipes) points at the same characters.
+ TextPool deduplicates: it hands back the one block it holds for each
+ distinct long string, so a book whose descriptions repeat stores each of
+ them once. The pool is only a cache of blocks, never their only owner, so
+ a RecipeText stays valid after its pool is gone.
+ @file RecipeText.hpp */
+
+#ifndef RECIPE_TEXT_
+#define RECIPE_TEXT_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+class RecipeText
+{
+public:
+  static constexpr std::size_t kInlineCapacity = 15;
+
+  /** @post the text is empty **/
+  RecipeText();
+
+  /** @param text the characters to copy; they are stored inline if they fit,
+             otherwise in a new block of their own **/
+  RecipeText(std::string_view text);
+  RecipeText(const std::string &text);
+  RecipeText(const char *text);
+
+  /** Copies share the block of a long string instead of copying it **/
+  RecipeText(const RecipeText &other);
+  RecipeText(RecipeText &&other) noexcept;
+  RecipeText &operator=(const RecipeText &other);
+  RecipeText &operator=(RecipeText &&other) noexcept;
+  ~RecipeText();
+
+  /** @return the characters; valid while this RecipeText is alive and
+              unchanged (an inline string moves with the RecipeText) **/
+  std::string_view view() const;
+  operator std::string_view() const { return view(); }
+
+  /** @return a std::string holding a copy of the characters; the implicit
+              conversion keeps APIs taking const std::string & working **/
+  std::string str() const;
+  operator std::string() const { return str(); }
+
+  const char *data() const;
+  char operator[](std::size_t i) const { return data()[i]; }
+  std::size_t size() const;
+  bool empty() const;
+
+  /** @return true if the characters are in a shared block **/
+  bool isShared() const;
+
+  /** @return the number of RecipeTexts (and pools) sharing the block; 0 for
+              an inline string **/
+  std::size_t useCount() const;
+
+  /** Text comparisons, against another RecipeText or anything that converts
+      to std::string_view, with no copy of either side **/
+  friend bool operator==(const RecipeText &a, const RecipeText &b) { return a.view() == b.view(); }
+  friend bool operator!=(const RecipeText &a, const RecipeText &b) { return a.view() != b.view(); }
+  friend bool operator<(const RecipeText &a, const RecipeText &b) { return a.view() < b.view(); }
+  friend bool operator>(const RecipeText &a, const RecipeText &b) { return a.view() > b.view(); }
+
+  template <class S, class = std::enable_if_t<std::is_convertible<const S &, std::string_view>::value &&
+                                              !std::is_same<S, RecipeText>::value>>
+  friend bool operator==(const RecipeText &a, const S &b) { return a.view() == std::string_view(b); }
+  template <class S, class = std::enable_if_t<std::is_convertible<const S &, std::string_view>::value &&
+                                              !std::is_same<S, RecipeText>::value>>
+  friend bool operator==(const S &a, const RecipeText &b) { return std::string_view(a) == b.view(); }
+  template <class S, class = std::enable_if_t<std::is_convertible<const S &, std::string_view>::value &&
+                                              !std::is_same<S, RecipeText>::value>>
+  friend bool operator!=(const RecipeText &a, const S &b) { return a.view() != std::string_view(b); }
+  template <class S, class = std::enable_if_t<std::is_convertible<const S &, std::string_view>::value &&
+                                              !std::is_same<S, RecipeText>::value>>
+  friend bool operator<(const RecipeText &a, const S &b) { return a.view() < std::string_view(b); }
+  template <class S, class = std::enable_if_t<std::is_convertible<const S &, std::string_view>::value &&
+                                              !std::is_same<S, RecipeText>::value>>
+  friend bool operator>(const RecipeText &a, const S &b) { return a.view() > std::string_view(b); }
+
+  friend std::ostream &operator<<(std::ostream &out, const RecipeText &text) { return out << text.view(); }
+
+private:
+  struct Block
+  {
+    std::atomic<std::uint32_t> references;
+    std::uint32_t size;
+    char data[1]; // size characters, allocated past the end of the struct
+  };
+
+  static constexpr unsigned char kSharedTag = 0xFF;
+
+  // bytes_[kInlineCapacity] is the length of an inline string, or kSharedTag
+  // when the first bytes hold a Block pointer instead
+  alignas(Block *) char bytes_[kInlineCapacity + 1];
+
+  Block *block() const;
+  void assign(std::string_view text);
+  void release();
+};
+
+class TextPool
+{
+public:
+  TextPool();
+
+  TextPool(const TextPool &) = delete;
+  TextPool &operator=(const TextPool &) = delete;
+  TextPool(TextPool &&) = default;
+  TextPool &operator=(TextPool &&) = default;
+
+  /** @param text the characters to store
+      @return a RecipeText equal to text; a long one shares the pool's block
+              for those characters, which is made on first use **/
+  RecipeText intern(std::string_view text);
+  RecipeText intern(const std::string &text) { return intern(std::string_view(text)); }
+  RecipeText intern(const char *text) { return intern(std::string_view(text)); }
+
+  /** @param text a RecipeText to deduplicate
+      @return the pool's RecipeText equal to text; text's own block is kept
+              if the pool has none yet, so nothing is copied **/
+  RecipeText intern(const RecipeText &text);
+
+  /** @post blocks held by nothing but the pool are freed
+      @return the number freed **/
+  std::size_t prune();
+
+  /** @post the pool holds nothing; RecipeTexts handed out stay valid **/
+  void clear();
+
+  /** @return the number of distinct long strings held **/
+  std::size_t size() const;
+
+private:
+  // Keyed by a view of the block's own characters, so lookups need no copy
+  std::unordered_map<std::string_view, RecipeText> texts_;
+  std::size_t prune_at_; // size at which intern prunes, about twice the size after the last prune
+};
+
+#endif
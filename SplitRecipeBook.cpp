@@ -0,0 +1,173 @@
+/** @file SplitRecipeBook.cpp */
+
+#include "SplitRecipeBook.hpp"
+
+RecipeEntry::RecipeEntry() : traits_(0), description_id_(0)
+{
+} // end default constructor
+
+RecipeEntry::RecipeEntry(RecipeText name, int difficulty_level, bool mastered, std::uint32_t description_id)
+    : name_(std::move(name)), traits_((static_cast<std::uint32_t>(difficulty_level) << 1) | (mastered ? 1 : 0)),
+      description_id_(description_id)
+{
+} // end constructor
+
+int RecipeEntry::getDifficultyLevel() const
+{
+  return static_cast<std::int32_t>(traits_) >> 1; // arithmetic shift keeps negative levels
+} // end getDifficultyLevel
+
+bool RecipeEntry::isMastered() const
+{
+  return (traits_ & 1) != 0;
+} // end isMastered
+
+void RecipeEntry::setMastered(bool mastered)
+{
+  traits_ = (traits_ & ~std::uint32_t(1)) | (mastered ? 1 : 0);
+} // end setMastered
+
+SplitRecipeBook::SplitRecipeBook()
+{
+} // end default constructor
+
+SplitRecipeBook::SplitRecipeBook(const RecipeBook &book)
+{
+  // The book is sorted by name, so the entries go in with one O(n) build
+  std::vector<RecipeEntry> entries;
+  entries.reserve(book.getNumberOfNodes());
+  descriptions_.reserve(book.getNumberOfNodes());
+  for (const Recipe &recipe : book)
+  {
+    entries.emplace_back(recipe.name_, recipe.difficulty_level_, recipe.mastered_, storeDescription(recipe.description_));
+    if (!recipe.mastered_)
+      mastery_index_.add(recipe.difficulty_level_);
+  }
+  buildFromSorted(entries.begin(), entries.end());
+} // end constructor
+
+SplitRecipeBook::SplitRecipeBook(const SplitRecipeBook &other)
+    : RecipeEntryTree(other), descriptions_(other.descriptions_), free_slots_(other.free_slots_),
+      mastery_index_(other.mastery_index_)
+{
+} // end copy constructor
+
+SplitRecipeBook &SplitRecipeBook::operator=(const SplitRecipeBook &other)
+{
+  if (this != &other)
+  {
+    RecipeEntryTree::operator=(other);
+    descriptions_ = other.descriptions_;
+    free_slots_ = other.free_slots_;
+    pool_.clear(); // a cache only; the copied descriptions keep their blocks
+    mastery_index_ = other.mastery_index_;
+  }
+  return *this;
+} // end copy assignment
+
+const RecipeEntry *SplitRecipeBook::findRecipe(std::string_view name) const
+{
+  return findItem(name);
+} // end findRecipe
+
+std::optional<Recipe> SplitRecipeBook::getRecipe(std::string_view name) const
+{
+  const RecipeEntry *entry = findItem(name);
+  if (entry == nullptr)
+    return std::nullopt;
+  return Recipe(entry->name_, entry->getDifficultyLevel(), getDescription(*entry), entry->isMastered());
+} // end getRecipe
+
+const RecipeText &SplitRecipeBook::getDescription(const RecipeEntry &entry) const
+{
+  return descriptions_[entry.description_id_];
+} // end getDescription
+
+bool SplitRecipeBook::addRecipe(const Recipe &recipe)
+{
+  // The entry goes in with the slot its description will get, so a
+  // duplicate is turned away in the same descent and touches neither the
+  // cold store nor the pool
+  std::uint32_t slot = nextSlot();
+  if (!tryInsert(RecipeEntry(recipe.name_, recipe.difficulty_level_, recipe.mastered_, slot)).second)
+    return false;
+  storeDescription(recipe.description_); // lands in slot
+  if (!recipe.mastered_)
+    mastery_index_.add(recipe.difficulty_level_);
+  return true;
+} // end addRecipe
+
+bool SplitRecipeBook::removeRecipe(std::string_view name)
+{
+  std::shared_ptr<BinaryNode<RecipeEntry>> removed = extract(name);
+  if (removed == nullptr)
+    return false;
+  const RecipeEntry &entry = removed->getItem();
+  descriptions_[entry.description_id_] = RecipeText(); // drops the reference now, not when the slot is reused
+  free_slots_.push_back(entry.description_id_);
+  if (!entry.isMastered())
+    mastery_index_.remove(entry.getDifficultyLevel());
+  return true;
+} // end removeRecipe
+
+bool SplitRecipeBook::setMastered(std::string_view name, bool mastered)
+{
+  std::shared_ptr<BinaryNode<RecipeEntry>> node = findForUpdate(name);
+  if (node == nullptr)
+    return false;
+  if (node->getItem().isMastered() == mastered)
+    return true;
+  RecipeEntry updated = node->getItem();
+  updated.setMastered(mastered);
+  if (mastered)
+    mastery_index_.remove(updated.getDifficultyLevel());
+  else
+    mastery_index_.add(updated.getDifficultyLevel());
+  node->setItem(std::move(updated));
+  return true;
+} // end setMastered
+
+void SplitRecipeBook::clear()
+{
+  RecipeEntryTree::clear();
+  descriptions_.clear();
+  free_slots_.clear();
+  pool_.clear();
+  mastery_index_.clear();
+} // end clear
+
+int SplitRecipeBook::caclulateMasteryHelper(const std::shared_ptr<BinaryNode<RecipeEntry>> &node, int difficulty) const
+{
+  return countIf(node, [difficulty](const RecipeEntry &entry) {
+    return !entry.isMastered() && entry.getDifficultyLevel() <= difficulty;
+  });
+} // end caclulateMasteryHelper
+
+int SplitRecipeBook::calculateMasteryPoints(std::string_view name) const
+{
+  const RecipeEntry *found = findItem(name);
+  if (found == nullptr)
+    return -1;
+  if (found->isMastered())
+    return 0;
+  return mastery_index_.countAtMost(found->getDifficultyLevel());
+} // end calculateMasteryPoints
+
+std::uint32_t SplitRecipeBook::storeDescription(const RecipeText &description)
+{
+  RecipeText pooled = pool_.intern(description);
+  if (!free_slots_.empty())
+  {
+    std::uint32_t slot = free_slots_.back();
+    free_slots_.pop_back();
+    descriptions_[slot] = std::move(pooled);
+    return slot;
+  }
+  descriptions_.push_back(std::move(pooled));
+  return static_cast<std::uint32_t>(descriptions_.size() - 1);
+} // end storeDescription
+
+std::uint32_t SplitRecipeBook::nextSlot() const
+{
+  return free_slots_.empty() ? static_cast<std::uint32_t>(descriptions_.size()) : free_slots_.back();
+} // end nextSlot
@@ -0,0 +1,120 @@
+/** A RecipeBook laid out for search and mastery scans, with the fields
+ split by how often they are read.
+ The tree nodes hold a RecipeEntry: the name (the key every search reads)
+ and one 32-bit word with difficulty_level_ and mastered_ (all a mastery
+ count reads), plus the slot of the description in a separate cold store.
+ An entry is 24 bytes where a Recipe is 48, so more nodes share each cache
+ line on the way down findRecipe and through caclulateMasteryHelper, and a
+ description is only read when getDescription or getRecipe asks for it.
+ Descriptions are interned as in RecipeBook (see RecipeText.hpp).
+ As with RecipeBook, the mastery index is kept up to date by this class's
+ own methods only.
+ @file SplitRecipeBook.hpp */
+
+#ifndef SPLIT_RECIPE_BOOK_
+#define SPLIT_RECIPE_BOOK_
+
+#include "RecipeBook.hpp"
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/** The hot fields of a Recipe, as a SplitRecipeBook node holds them **/
+struct RecipeEntry
+{
+  RecipeText name_;
+  std::uint32_t traits_;         // difficulty_level_ in the top 31 bits, mastered_ in the lowest
+  std::uint32_t description_id_; // slot of the description in the book's cold store
+
+  RecipeEntry();
+  RecipeEntry(RecipeText name, int difficulty_level, bool mastered, std::uint32_t description_id);
+
+  /** @return the difficulty level; levels must fit in 31 bits **/
+  int getDifficultyLevel() const;
+  bool isMastered() const;
+  void setMastered(bool mastered);
+};
+
+/** Orders RecipeEntries by name_ **/
+struct RecipeEntryNameKey
+{
+  static std::string_view key(const RecipeEntry &entry) { return entry.name_; }
+};
+
+typedef BinarySearchTree<RecipeEntry, AvlPolicy, NodePoolAllocator<BinaryNode<RecipeEntry>>, RecipeEntryNameKey>
+    RecipeEntryTree;
+
+class SplitRecipeBook : public RecipeEntryTree
+{
+public:
+  SplitRecipeBook();
+
+  /** @param book the book to copy
+      @post holds every Recipe of book, in O(n); descriptions are shared
+            with book, not copied **/
+  explicit SplitRecipeBook(const RecipeBook &book);
+
+  SplitRecipeBook(const SplitRecipeBook &other);
+  SplitRecipeBook &operator=(const SplitRecipeBook &other);
+  SplitRecipeBook(SplitRecipeBook &&other) = default;
+  SplitRecipeBook &operator=(SplitRecipeBook &&other) = default;
+
+  /** @param name the name to look up
+      @return the hot fields of the Recipe with that name, nullptr if not
+              found; the descent reads names only **/
+  const RecipeEntry *findRecipe(std::string_view name) const;
+
+  /** @param name the name to look up
+      @return the whole Recipe with that name, description fetched from the
+              cold store; nothing if not found **/
+  std::optional<Recipe> getRecipe(std::string_view name) const;
+
+  /** @param entry an entry of this book
+      @return its description **/
+  const RecipeText &getDescription(const RecipeEntry &entry) const;
+
+  /** @param recipe the Recipe to add
+      @return true if it was added; false if a Recipe with the same name is
+              already in the book **/
+  bool addRecipe(const Recipe &recipe);
+
+  /** @param name the name of the Recipe to remove
+      @post its description slot is free for the next add
+      @return true if it was removed **/
+  bool removeRecipe(std::string_view name);
+
+  /** @param name the name of the Recipe
+      @param mastered the new value of mastered_
+      @return true if the Recipe was found **/
+  bool setMastered(std::string_view name, bool mastered);
+
+  /** @post the book, its cold store and its indexes are empty **/
+  void clear();
+
+  /** @param node the root of a subtree of this book
+      @param difficulty the difficulty level to count up to
+      @return the number of unmastered Recipes of the subtree at or below
+              difficulty, read from the packed words alone **/
+  int caclulateMasteryHelper(const std::shared_ptr<BinaryNode<RecipeEntry>> &node, int difficulty) const;
+
+  /** @param name the name of the Recipe
+      @return the mastery points needed, as RecipeBook::calculateMasteryPoints,
+              answered from the mastery index; -1 if not found **/
+  int calculateMasteryPoints(std::string_view name) const;
+
+private:
+  std::vector<RecipeText> descriptions_;  // the cold store, indexed by description_id_
+  std::vector<std::uint32_t> free_slots_; // slots of removed Recipes, reused first
+  TextPool pool_;                         // interns what goes into descriptions_
+  MasteryIndex mastery_index_;            // unmastered Recipes counted by difficulty level
+
+  /** @param description the description to store
+      @return the slot it was stored in **/
+  std::uint32_t storeDescription(const RecipeText &description);
+
+  /** @return the slot the next storeDescription will use **/
+  std::uint32_t nextSlot() const;
+};
+
+#endif
@@ -0,0 +1,199 @@
+/** @file ThreadPool.cpp */
+
+#include "ThreadPool.hpp"
+#include <iterator>
+#include <utility>
+
+namespace
+{
+thread_local ThreadPool::TaskGroup *running_group = nullptr; // the group of the task this thread is running
+} // namespace
+
+ThreadPool::TaskGroup::TaskGroup(ThreadPool &pool) : pool_(pool), parent_(running_group), pending_(0)
+{
+} // end constructor
+
+ThreadPool::TaskGroup::~TaskGroup()
+{
+  try
+  {
+    wait();
+  }
+  catch (...)
+  {
+  }
+} // end destructor
+
+void ThreadPool::TaskGroup::run(std::function<void()> task)
+{
+  pending_.fetch_add(1, std::memory_order_relaxed);
+  if (pool_.getWorkerCount() == 0)
+    execute(task); // nobody else could run it
+  else
+    pool_.push(this, std::move(task));
+} // end run
+
+void ThreadPool::TaskGroup::wait()
+{
+  std::unique_lock<std::mutex> lock(pool_.mutex_);
+  while (pending_.load(std::memory_order_acquire) > 0)
+  {
+    // Help with the group's own work first; sleep once the rest runs elsewhere
+    Task task;
+    if (pool_.takeQueued(this, task))
+    {
+      lock.unlock();
+      task.group->execute(task.work);
+      lock.lock();
+      continue;
+    }
+    pool_.sleeping_waiters_++;
+    pool_.progress_.wait(lock);
+    pool_.sleeping_waiters_--;
+  }
+  lock.unlock();
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    std::swap(error, error_);
+  }
+  if (error)
+    std::rethrow_exception(error);
+} // end wait
+
+void ThreadPool::TaskGroup::execute(const std::function<void()> &task)
+{
+  TaskGroup *outer = running_group;
+  running_group = this; // groups made by the task are its children
+  try
+  {
+    task();
+  }
+  catch (...)
+  {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    if (!error_)
+      error_ = std::current_exception();
+  }
+  running_group = outer;
+  // Whoever waits may destroy the group as soon as pending_ reaches 0, so
+  // the pool, not the group, is touched after that
+  ThreadPool &pool = pool_;
+  if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    pool.groupDone();
+} // end execute
+
+bool ThreadPool::TaskGroup::isAncestorOf(const TaskGroup *group) const
+{
+  for (; group != nullptr; group = group->parent_)
+  {
+    if (group == this)
+      return true;
+  }
+  return false;
+} // end isAncestorOf
+
+ThreadPool::ThreadPool(unsigned worker_count) : sleeping_waiters_(0), worker_count_(0), stopping_(false)
+{
+  start(worker_count);
+} // end constructor
+
+ThreadPool::~ThreadPool()
+{
+  stop();
+} // end destructor
+
+ThreadPool &ThreadPool::shared()
+{
+  static ThreadPool pool(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0);
+  return pool;
+} // end shared
+
+unsigned ThreadPool::getWorkerCount() const
+{
+  return worker_count_.load(std::memory_order_relaxed);
+} // end getWorkerCount
+
+void ThreadPool::resize(unsigned worker_count)
+{
+  stop();
+  start(worker_count);
+} // end resize
+
+void ThreadPool::push(TaskGroup *group, std::function<void()> work)
+{
+  bool waiters;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(Task{group, std::move(work)});
+    waiters = sleeping_waiters_ > 0;
+  }
+  ready_.notify_one();
+  if (waiters)
+    progress_.notify_all(); // it may be the child of a sleeping waiter's group
+} // end push
+
+bool ThreadPool::takeQueued(const TaskGroup *group, Task &task)
+{
+  // The newest task is the smallest piece of a fork-join split
+  for (auto it = tasks_.rbegin(); it != tasks_.rend(); ++it)
+  {
+    if (group->isAncestorOf(it->group))
+    {
+      task = std::move(*it);
+      tasks_.erase(std::next(it).base());
+      return true;
+    }
+  }
+  return false;
+} // end takeQueued
+
+void ThreadPool::groupDone()
+{
+  {
+    // Taking the lock orders this after a waiter's check of pending_, so
+    // the wakeup cannot fall between its check and its sleep
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sleeping_waiters_ == 0)
+      return;
+  }
+  progress_.notify_all();
+} // end groupDone
+
+void ThreadPool::workerLoop()
+{
+  while (true)
+  {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ready_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+      if (tasks_.empty())
+        return; // stopping, and nothing is left to do
+      task = std::move(tasks_.front()); // the oldest task is the biggest piece left
+      tasks_.pop_front();
+    }
+    task.group->execute(task.work);
+  }
+} // end workerLoop
+
+void ThreadPool::start(unsigned worker_count)
+{
+  stopping_ = false;
+  for (unsigned i = 0; i < worker_count; i++)
+    workers_.emplace_back(&ThreadPool::workerLoop, this);
+  worker_count_.store(worker_count, std::memory_order_relaxed);
+} // end start
+
+void ThreadPool::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  ready_.notify_all();
+  for (std::thread &worker : workers_)
+    worker.join();
+  workers_.clear();
+  worker_count_.store(0, std::memory_order_relaxed);
+} // end stop
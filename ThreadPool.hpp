@@ -0,0 +1,128 @@
+/** A fixed set of worker threads for fork-join work inside the library.
+ Work is forked through a TaskGroup: run queues a task, and wait blocks
+ until every task of the group is done. A thread that waits runs queued
+ tasks of its group, or of groups forked from inside them, in the meantime,
+ so tasks may fork and wait on their own groups without tying up the
+ workers (a task is never waited on by a thread that cannot make
+ progress). It never picks up unrelated work, which could hold it up for
+ long or run under locks the waiter holds; with nothing of its own queued
+ it sleeps until its group is done or more of its work is queued. With no
+ workers, as on a single core, run simply calls the task, so forking code
+ needs no serial twin.
+ @file ThreadPool.hpp */
+
+#ifndef THREAD_POOL_
+#define THREAD_POOL_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+  /** Tasks forked together and waited for together. **/
+  class TaskGroup
+  {
+  public:
+    /** @param pool the pool the tasks run on; it must outlive the group
+        @post if made inside a task, the group is a child of that task's group **/
+    explicit TaskGroup(ThreadPool &pool);
+
+    /** @post every task of the group is done; their exceptions are dropped **/
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    /** @param task called once, on a worker or on the thread that waits
+        @post task is queued, or done already if the pool has no workers **/
+    void run(std::function<void()> task);
+
+    /** @post every task of the group is done; queued tasks of the group
+              and of its child groups were run on this thread while waiting
+        @throws the first exception a task of the group threw **/
+    void wait();
+
+  private:
+    ThreadPool &pool_;
+    TaskGroup *parent_;        // the group of the task this group was made in, if any
+    std::atomic<int> pending_; // tasks queued or running
+    std::mutex error_mutex_;
+    std::exception_ptr error_; // the first exception a task threw
+
+    /** called by run and the pool
+        @post task ran, its exception (if any) is kept, and pending_ dropped **/
+    void execute(const std::function<void()> &task);
+
+    /** @return true if group is this group or one forked inside its tasks **/
+    bool isAncestorOf(const TaskGroup *group) const;
+
+    friend class ThreadPool;
+  };
+
+  /** @param worker_count the number of worker threads to start **/
+  explicit ThreadPool(unsigned worker_count);
+
+  /** @post the queued tasks are done and the workers have stopped **/
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /** @return the pool the library forks onto, with one worker per core
+              besides the calling thread; started on first use **/
+  static ThreadPool &shared();
+
+  /** @return the number of worker threads **/
+  unsigned getWorkerCount() const;
+
+  /** @param worker_count the number of worker threads to run from now on
+      @pre no task is queued or running **/
+  void resize(unsigned worker_count);
+
+private:
+  struct Task
+  {
+    TaskGroup *group;
+    std::function<void()> work;
+  };
+
+  std::mutex mutex_;
+  std::condition_variable ready_;    // signalled when a task is queued or the pool stops
+  std::condition_variable progress_; // signalled for sleeping waiters: a task queued or a group done
+  unsigned sleeping_waiters_;
+  std::deque<Task> tasks_;
+  std::vector<std::thread> workers_;
+  std::atomic<unsigned> worker_count_;
+  bool stopping_;
+
+  /** called by TaskGroup::run **/
+  void push(TaskGroup *group, std::function<void()> work);
+
+  /** called by TaskGroup::wait, with mutex_ held
+      @param group the group waited for
+      @param task set to the newest queued task of group or of a child group
+      @return true if there was one; it is taken off the queue **/
+  bool takeQueued(const TaskGroup *group, Task &task);
+
+  /** called by TaskGroup::execute when a group has no task left
+      @post the sleeping waiters are woken to check their groups **/
+  void groupDone();
+
+  /** the loop of every worker thread **/
+  void workerLoop();
+
+  /** @post worker_count workers are running **/
+  void start(unsigned worker_count);
+
+  /** @post the queued tasks are done and the workers have stopped **/
+  void stop();
+};
+
+#endif
@@ -0,0 +1,69 @@
+/** @file TreeTraversal.cpp */
+
+#include "TreeTraversal.hpp"
+#include <utility>
+#include <vector>
+
+template <class T, class Visit>
+void preorderTraverse(const std::shared_ptr<BinaryNode<T>> &root_ptr, Visit visit)
+{
+  std::vector<const std::shared_ptr<BinaryNode<T>> *> pending;
+  if (root_ptr != nullptr)
+    pending.push_back(&root_ptr);
+  while (!pending.empty())
+  {
+    const std::shared_ptr<BinaryNode<T>> &node_ptr = *pending.back();
+    pending.pop_back();
+    visit(node_ptr);
+    // Right is pushed first so the left subtree comes off the stack first
+    if (node_ptr->getRightChildPtr() != nullptr)
+      pending.push_back(&node_ptr->getRightChildPtr());
+    if (node_ptr->getLeftChildPtr() != nullptr)
+      pending.push_back(&node_ptr->getLeftChildPtr());
+  }
+} // end preorderTraverse
+
+template <class T, class Visit>
+void inorderTraverse(const std::shared_ptr<BinaryNode<T>> &root_ptr, Visit visit)
+{
+  std::vector<const std::shared_ptr<BinaryNode<T>> *> pending;
+  const std::shared_ptr<BinaryNode<T>> *link = &root_ptr;
+  while (*link != nullptr || !pending.empty())
+  {
+    // Go as far left as possible, remembering the way back
+    while (*link != nullptr)
+    {
+      pending.push_back(link);
+      link = &(*link)->getLeftChildPtr();
+    }
+    const std::shared_ptr<BinaryNode<T>> &node_ptr = *pending.back();
+    pending.pop_back();
+    visit(node_ptr);
+    link = &node_ptr->getRightChildPtr();
+  }
+} // end inorderTraverse
+
+template <class T, class Visit>
+void postorderTraverse(const std::shared_ptr<BinaryNode<T>> &root_ptr, Visit visit)
+{
+  // Each entry is a link and whether its subtrees have been pushed already
+  std::vector<std::pair<const std::shared_ptr<BinaryNode<T>> *, bool>> pending;
+  if (root_ptr != nullptr)
+    pending.push_back(std::make_pair(&root_ptr, false));
+  while (!pending.empty())
+  {
+    std::pair<const std::shared_ptr<BinaryNode<T>> *, bool> &top = pending.back();
+    const std::shared_ptr<BinaryNode<T>> &node_ptr = *top.first;
+    if (top.second)
+    {
+      pending.pop_back();
+      visit(node_ptr);
+      continue;
+    }
+    top.second = true; // top may move once the vector grows
+    if (node_ptr->getRightChildPtr() != nullptr)
+      pending.push_back(std::make_pair(&node_ptr->getRightChildPtr(), false));
+    if (node_ptr->getLeftChildPtr() != nullptr)
+      pending.push_back(std::make_pair(&node_ptr->getLeftChildPtr(), false));
+  }
+} // end postorderTraverse
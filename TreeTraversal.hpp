@@ -0,0 +1,31 @@
+/** Iterative traversals of a link-based binary tree.
+ Each walk keeps the pending links on an explicit stack on the heap, so a
+ tree of any depth can be walked without growing the call stack, and no
+ shared_ptr is copied along the way.
+ visit is called as visit(node_ptr) with a const std::shared_ptr<BinaryNode<T>>&.
+ @file TreeTraversal.hpp */
+
+#ifndef TREE_TRAVERSAL_
+#define TREE_TRAVERSAL_
+
+#include "BinaryNode.hpp"
+#include <memory>
+
+/** @param root_ptr the root of the tree to walk
+    @post visit was called on every node, each node before its subtrees **/
+template <class T, class Visit>
+void preorderTraverse(const std::shared_ptr<BinaryNode<T>> &root_ptr, Visit visit);
+
+/** @param root_ptr the root of the tree to walk
+    @post visit was called on every node in key order **/
+template <class T, class Visit>
+void inorderTraverse(const std::shared_ptr<BinaryNode<T>> &root_ptr, Visit visit);
+
+/** @param root_ptr the root of the tree to walk
+    @post visit was called on every node after both of its subtrees; visit
+          may change the node's own fields but not its links **/
+template <class T, class Visit>
+void postorderTraverse(const std::shared_ptr<BinaryNode<T>> &root_ptr, Visit visit);
+
+#include "TreeTraversal.cpp"
+#endif